@@ -0,0 +1,233 @@
+/****************************************************************************
+  FileName     [ cirBalance.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define AIG balancing for minimum logic depth ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2014 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include "cirMgr.h"
+#include "cirGate.h"
+#include "myHashMap.h"
+#include "util.h"
+
+using namespace std;
+
+// A supergate is a maximal tree of ANDs joined by plain (non-inverted)
+// edges whose inner nodes have a single fanout; it is a multi-input AND of
+// its leaves. Supergates are rebuilt, fanins first, as trees that always
+// pair the two leaves of lowest level, which gives the minimum depth.
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// Literal: gate pointer + inverted
+static inline CirGate* balGate(size_t lit) { return (CirGate*)(lit & ~(size_t)1); }
+
+// Heap order of leaves: the earliest arrival on top, IDs breaking ties so
+// runs are reproducible
+struct BalLater
+{
+	BalLater(const vector<unsigned>& level): _level(level) {}
+	bool operator () (size_t a, size_t b) const {
+		unsigned ia = balGate(a)->getGateID(), ib = balGate(b)->getGateID();
+		if (_level[ia] != _level[ib]) return _level[ia] > _level[ib];
+		return ia != ib ? ia > ib : a > b;
+	}
+	const vector<unsigned>& _level;
+};
+
+/************************************/
+/*   HashKey class implementation   */
+/************************************/
+class BalKey
+{
+public:
+	BalKey(): _in0(0), _in1(0) {}
+	BalKey(size_t lit0, size_t lit1) {
+		_in0 = lit0 < lit1 ? lit0 : lit1; _in1 = lit0 < lit1 ? lit1 : lit0;
+	}
+	~BalKey() {}
+	bool operator == (const BalKey& k) const { return _in0 == k._in0 && _in1 == k._in1; }
+	size_t operator() () const { return _in0 + _in1 + (_in0 % 256) * (_in1 % 256); }
+
+private:
+	size_t   _in0;
+	size_t   _in1;
+};
+
+static HashMap<BalKey, CirGate*>* balHash = 0;
+
+/***********************************************/
+/*   Public member functions about balancing   */
+/***********************************************/
+void
+CirMgr::balance()
+{
+	if (_dfsList.size() == 0) cirDFSearch();
+	// Fanout pins of the listed gates; a single-fanout AND reached by a
+	// plain edge from another AND is inside a supergate
+	IdList ref(_totList.size(), 0);
+	for (size_t i = 0; i < _dfsList.size(); ++i) {
+		CirGate* g = _dfsList[i];
+		if (g->getInput0()) ++ref[g->getInput0()->getGateID()];
+		if (g->getInput1()) ++ref[g->getInput1()->getGateID()];
+	}
+	_balInner.assign(_totList.size(), false);
+	_balLevel.assign(_totList.size(), 0);
+	balHash = new HashMap<BalKey, CirGate*>(getHashSize(_dfsList.size()));
+	for (size_t i = 0; i < _dfsList.size(); ++i) {
+		CirGate* g = _dfsList[i];
+		if (g->getType() != AIG_GATE) continue;
+		CirGate* in[2] = { g->getInput0(), g->getInput1() };
+		bool inv[2] = { g->getisInv0(), g->getisInv1() };
+		for (size_t k = 0; k < 2; ++k)
+			if (!inv[k] && in[k]->getType() == AIG_GATE && ref[in[k]->getGateID()] == 1)
+				_balInner[in[k]->getGateID()] = true;
+		balHash->replaceInsert(BalKey((size_t)in[0] + inv[0], (size_t)in[1] + inv[1]), g);
+	}
+	GateList order = _dfsList;
+	for (size_t i = 0; i < order.size(); ++i) {
+		CirGate* gate = order[i];
+		unsigned id = gate->getGateID();
+		if (gate->getType() != AIG_GATE || _totList[id] != gate) continue;
+		_balLevel[id] = 1 + std::max(_balLevel[gate->getInput0()->getGateID()], _balLevel[gate->getInput1()->getGateID()]);
+		if (!_balInner[id]) balRoot(gate);
+	}
+	delete balHash; balHash = 0;
+	_balLevel.clear(); _balInner.clear();
+	cirDFSearch();
+}
+
+/************************************************/
+/*   Private member functions about balancing   */
+/************************************************/
+// Gather the leaves of the supergate under "gate" and its inner ANDs
+void
+CirMgr::balCollect(CirGate* gate, vector<size_t>& leaves, GateList& inner)
+{
+	// Explicit stack: chains from the front-end can be very long
+	GateList stack(1, gate);
+	while (!stack.empty()) {
+		CirGate* g = stack.back(); stack.pop_back();
+		CirGate* in[2] = { g->getInput0(), g->getInput1() };
+		bool inv[2] = { g->getisInv0(), g->getisInv1() };
+		for (size_t k = 0; k < 2; ++k) {
+			if (!inv[k] && _balInner[in[k]->getGateID()] && _totList[in[k]->getGateID()] == in[k]) {
+				inner.push_back(in[k]);
+				stack.push_back(in[k]);
+			}
+			else leaves.push_back((size_t)in[k] + inv[k]);
+		}
+	}
+}
+
+// AND of two literals through the structural hash; new gates take their
+// IDs from "freeIDs"
+size_t
+CirMgr::balAnd(size_t a, size_t b, IdList& freeIDs)
+{
+	CirGate* found = 0;
+	unsigned level = 1 + std::max(_balLevel[balGate(a)->getGateID()], _balLevel[balGate(b)->getGateID()]);
+	if (balHash->check(BalKey(a, b), found) && _totList[found->getGateID()] == found && !_balInner[found->getGateID()]) {
+		// It may come later in the DFS order and have no level yet
+		_balLevel[found->getGateID()] = level;
+		return (size_t)found;
+	}
+	assert(!freeIDs.empty());
+	CirGate* g = new CirAIGGate;
+	g->setGateID(freeIDs.back()); freeIDs.pop_back();
+	g->setInput(balGate(a), a & 1, balGate(b), b & 1);
+	balGate(a)->addOutput(g); balGate(b)->addOutput(g);
+	_totList[g->getGateID()] = g; ++_aigNum;
+	_balInner[g->getGateID()] = false;
+	_balLevel[g->getGateID()] = level;
+	balHash->replaceInsert(BalKey(a, b), g);
+	return (size_t)g;
+}
+
+void
+CirMgr::balRoot(CirGate* gate)
+{
+	vector<size_t> leaves; GateList inner;
+	balCollect(gate, leaves, inner);
+	if (inner.empty()) return;
+	// x & x = x, x & !x = 0, x & 1 = x
+	size_t const0 = (size_t)_totList[0];
+	sort(leaves.begin(), leaves.end());
+	leaves.erase(unique(leaves.begin(), leaves.end()), leaves.end());
+	leaves.erase(remove(leaves.begin(), leaves.end(), const0 + 1), leaves.end());
+	bool isConst = (find(leaves.begin(), leaves.end(), const0) != leaves.end());
+	for (size_t i = 0; i + 1 < leaves.size(); ++i)
+		if ((leaves[i] ^ leaves[i + 1]) == 1) isConst = true;
+	// Depth of the balanced tree; keep the gate if it is no shallower
+	unsigned id = gate->getGateID(), depth = 0;
+	vector<unsigned> lv;
+	for (size_t i = 0; i < leaves.size(); ++i) lv.push_back(_balLevel[balGate(leaves[i])->getGateID()]);
+	make_heap(lv.begin(), lv.end(), greater<unsigned>());
+	while (lv.size() > 1) {
+		pop_heap(lv.begin(), lv.end(), greater<unsigned>()); lv.pop_back();
+		pop_heap(lv.begin(), lv.end(), greater<unsigned>());
+		++lv.back();
+		push_heap(lv.begin(), lv.end(), greater<unsigned>());
+	}
+	if (!lv.empty()) depth = lv[0];
+	if (isConst) depth = 0;
+	if (depth >= _balLevel[id]) return;
+	cout << "Balancing: " << id << " level " << _balLevel[id] << " -> " << depth << "..." << endl;
+	// Free the inner gates; their IDs go to the new gates
+	IdList freeIDs;
+	for (size_t i = 0; i < inner.size(); ++i) {
+		_totList[inner[i]->getGateID()] = 0; --_aigNum;
+		freeIDs.push_back(inner[i]->getGateID());
+	}
+	// Drop them from the fanouts of the leaves in one pass per leaf, as a
+	// leaf may feed most of a long chain
+	CirGate::setGlobalRef();
+	for (size_t i = 0; i < inner.size(); ++i) {
+		CirGate* in[2] = { inner[i]->getInput0(), inner[i]->getInput1() };
+		for (size_t k = 0; k < 2; ++k) {
+			if (_totList[in[k]->getGateID()] != in[k] || in[k]->eqGlobalRef()) continue;
+			in[k]->setToGlobalRef();
+			GateList outList = in[k]->getOutput();
+			in[k]->clearOutput();
+			for (size_t j = 0; j < outList.size(); ++j)
+				if (_totList[outList[j]->getGateID()] == outList[j]) in[k]->addOutput(outList[j]);
+		}
+	}
+	gate->getInput0()->removeOutput(gate); gate->getInput1()->removeOutput(gate);
+	gate->setInput(0, false, 0, false);
+	size_t root = const0 + (leaves.empty() ? 1 : 0);
+	if (!isConst && !leaves.empty()) {
+		// Pair the two earliest leaves until two are left
+		BalLater cmp(_balLevel);
+		make_heap(leaves.begin(), leaves.end(), cmp);
+		while (leaves.size() > 2) {
+			pop_heap(leaves.begin(), leaves.end(), cmp); size_t a = leaves.back(); leaves.pop_back();
+			pop_heap(leaves.begin(), leaves.end(), cmp); size_t b = leaves.back(); leaves.pop_back();
+			leaves.push_back(balAnd(a, b, freeIDs));
+			push_heap(leaves.begin(), leaves.end(), cmp);
+		}
+		if (leaves.size() == 1) root = leaves[0];
+		else {
+			CirGate* found = 0;
+			if (balHash->check(BalKey(leaves[0], leaves[1]), found) && found != gate
+				&& _totList[found->getGateID()] == found && !_balInner[found->getGateID()])
+				root = (size_t)found;
+			else {
+				// The top AND stays in "gate", which keeps its ID and fanouts
+				gate->setInput(balGate(leaves[0]), leaves[0] & 1, balGate(leaves[1]), leaves[1] & 1);
+				balGate(leaves[0])->addOutput(gate); balGate(leaves[1])->addOutput(gate);
+				_balLevel[id] = depth;
+				balHash->replaceInsert(BalKey(leaves[0], leaves[1]), gate);
+				return;
+			}
+		}
+	}
+	_balLevel[id] = _balLevel[balGate(root)->getGateID()];
+	gateMerge(balGate(root), gate, root & 1);
+	_totList[id] = 0; --_aigNum;
+}
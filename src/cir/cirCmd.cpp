@@ -27,9 +27,15 @@ initCirCmd()
          cmdMgr->regCmd("CIRSWeep", 5, new CirSweepCmd) &&
          cmdMgr->regCmd("CIROPTimize", 6, new CirOptCmd) &&
          cmdMgr->regCmd("CIRSTRash", 6, new CirStrashCmd) &&
+         cmdMgr->regCmd("CIRREWrite", 6, new CirRewriteCmd) &&
+         cmdMgr->regCmd("CIRBALance", 6, new CirBalanceCmd) &&
+         cmdMgr->regCmd("CIRRESub", 6, new CirResubCmd) &&
          cmdMgr->regCmd("CIRSIMulate", 6, new CirSimCmd) &&
          cmdMgr->regCmd("CIRFraig", 4, new CirFraigCmd) &&
-         cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd)
+         cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd) &&
+         cmdMgr->regCmd("CIRSAVE", 7, new CirSaveCmd) &&
+         cmdMgr->regCmd("CIRLOAD", 7, new CirLoadCmd) &&
+         cmdMgr->regCmd("CIRCHeck", 5, new CirCheckCmd)
       )) {
       cerr << "Registering \"cir\" commands fails... exiting" << endl;
       return false;
@@ -373,8 +379,134 @@ CirStrashCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRSIMulate <-Random | -File <string patternFile>>
-//                [-Output (string logFile)]
+//    CIRREWrite
+//----------------------------------------------------------------------
+CmdExecStatus
+CirRewriteCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   CmdExec::lexOptions(option, options);
+
+   if (!options.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+
+   assert(curCmd != CIRINIT);
+   if (curCmd == CIRSIMULATE) {
+      cerr << "Error: circuit has been simulated!! Do \"CIRFraig\" first!!"
+           << endl;
+      return CMD_EXEC_ERROR;
+   }
+   cirMgr->rewrite();
+   curCmd = CIROPT;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirRewriteCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRREWrite" << endl;
+}
+
+void
+CirRewriteCmd::help() const
+{
+   cout << setw(15) << left << "CIRREWrite: "
+        << "rewrite 4-input cuts with smaller precomputed structures\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRBALance
+//----------------------------------------------------------------------
+CmdExecStatus
+CirBalanceCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   CmdExec::lexOptions(option, options);
+
+   if (!options.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+
+   assert(curCmd != CIRINIT);
+   if (curCmd == CIRSIMULATE) {
+      cerr << "Error: circuit has been simulated!! Do \"CIRFraig\" first!!"
+           << endl;
+      return CMD_EXEC_ERROR;
+   }
+   cirMgr->balance();
+   curCmd = CIROPT;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirBalanceCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRBALance" << endl;
+}
+
+void
+CirBalanceCmd::help() const
+{
+   cout << setw(15) << left << "CIRBALance: "
+        << "rebuild AND trees for minimum logic depth\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRRESub
+//----------------------------------------------------------------------
+CmdExecStatus
+CirResubCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   CmdExec::lexOptions(option, options);
+
+   if (!options.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+
+   // The signatures come from the last simulation; the FEC groups stay
+   // valid, so "CIRFraig" can follow
+   if (curCmd != CIRSIMULATE) {
+      cerr << "Error: circuit is not yet simulated!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   cirMgr->resub();
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirResubCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRRESub" << endl;
+}
+
+void
+CirResubCmd::help() const
+{
+   cout << setw(15) << left << "CIRRESub: "
+        << "re-express gates by one or two divisors found by simulation\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRSIMulate <-Random | -File <string patternFile> | -Exhaustive |
+//                 -Targeted>
+//                [-Output (string logFile) [-Binary]]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirSimCmd::exec(const string& option)
@@ -389,15 +521,27 @@ CirSimCmd::exec(const string& option)
 
    ifstream patternFile;
    ofstream logFile;
-   bool doRandom = false, doFile = false, doLog = false;
+   string logName;
+   bool doRandom = false, doFile = false, doExhaust = false, doTarget = false;
+   bool doLog = false, doBinary = false;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Random", options[i], 2) == 0) {
-         if (doRandom || doFile)
+         if (doRandom || doFile || doExhaust || doTarget)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          doRandom = true;
       }
+      else if (myStrNCmp("-Exhaustive", options[i], 2) == 0) {
+         if (doRandom || doFile || doExhaust || doTarget)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doExhaust = true;
+      }
+      else if (myStrNCmp("-Targeted", options[i], 2) == 0) {
+         if (doRandom || doFile || doExhaust || doTarget)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doTarget = true;
+      }
       else if (myStrNCmp("-File", options[i], 2) == 0) {
-         if (doRandom || doFile)
+         if (doRandom || doFile || doExhaust || doTarget)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
@@ -411,25 +555,48 @@ CirSimCmd::exec(const string& option)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         logFile.open(options[i].c_str(), ios::out);
-         if (!logFile)
-            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         logName = options[i];
          doLog = true;
       }
+      else if (myStrNCmp("-Binary", options[i], 2) == 0) {
+         if (doBinary)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doBinary = true;
+      }
       else
          return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
    }
 
-   if (!doRandom && !doFile)
+   if (!doRandom && !doFile && !doExhaust && !doTarget)
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   // Targeted patterns split the groups of an earlier simulation
+   if (doTarget && curCmd != CIRSIMULATE) {
+      cerr << "Error: circuit is not yet simulated!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   if (doBinary && !doLog)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, "-Binary");
+   if (doLog) {
+      logFile.open(logName.c_str(), doBinary? (ios::out | ios::binary) : ios::out);
+      if (!logFile)
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, logName);
+   }
 
    assert (curCmd != CIRINIT);
    if (doLog)
-      cirMgr->setSimLog(&logFile);
+      cirMgr->setSimLog(&logFile, doBinary);
    else cirMgr->setSimLog(0);
 
    if (doRandom)
       cirMgr->randomSim();
+   else if (doExhaust) {
+      if (!cirMgr->exhaustiveSim()) {
+         cirMgr->setSimLog(0);
+         return CMD_EXEC_ERROR;
+      }
+   }
+   else if (doTarget)
+      cirMgr->targetedSim();
    else
       cirMgr->fileSim(patternFile);
    cirMgr->setSimLog(0);
@@ -441,8 +608,9 @@ CirSimCmd::exec(const string& option)
 void
 CirSimCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRSIMulate <-Random | -File <string patternFile>>\n"
-      << "                   [-Output (string logFile)]" << endl;
+   os << "Usage: CIRSIMulate <-Random | -File <string patternFile> | -Exhaustive |\n"
+      << "                    -Targeted>\n"
+      << "                   [-Output (string logFile) [-Binary]]" << endl;
 }
 
 void
@@ -453,7 +621,8 @@ CirSimCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRFraig
+//    CIRFraig [-Circuit | -Proof <(string proofFile)>]
+//             [-Race <(int racers)> [(int budget)]]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirFraigCmd::exec(const string& option)
@@ -466,14 +635,52 @@ CirFraigCmd::exec(const string& option)
    vector<string> options;
    CmdExec::lexOptions(option, options);
 
-   if (!options.empty())
-      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+   bool doCircuit = false, doProof = false, doRace = false;
+   string proofName;
+   int racers = 1, budget = 1000;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Circuit", options[i], 2) == 0) {
+         if (doCircuit || doProof)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doCircuit = true;
+      }
+      else if (myStrNCmp("-Proof", options[i], 2) == 0) {
+         if (doCircuit || doProof)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         proofName = options[i];
+         doProof = true;
+      }
+      else if (myStrNCmp("-Race", options[i], 2) == 0) {
+         if (doRace)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], racers) || racers < 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         // The conflict budget is optional
+         if (i + 1 < n && myStr2Int(options[i+1], budget)) {
+            if (budget < 0)
+               return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i+1]);
+            ++i;
+         }
+         doRace = true;
+      }
+      else
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+   }
 
    if (curCmd != CIRSIMULATE) {
       cerr << "Error: circuit is not yet simulated!!" << endl;
       return CMD_EXEC_ERROR;
    }
-   cirMgr->fraig();
+   if (doProof && !cirMgr->setProof(proofName))
+      return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, proofName);
+   // Hard queries are raced only on request, so a plain run is deterministic
+   cirMgr->setRace(racers, budget);
+   cirMgr->fraig(doCircuit);
+   if (doProof) cirMgr->setProof("");
    curCmd = CIRFRAIG;
 
    return CMD_EXEC_DONE;
@@ -482,7 +689,8 @@ CirFraigCmd::exec(const string& option)
 void
 CirFraigCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRFraig" << endl;
+   os << "Usage: CIRFraig [-Circuit | -Proof <(string proofFile)>]\n"
+      << "                [-Race <(int racers)> [(int budget)]]" << endl;
 }
 
 void
@@ -536,3 +744,156 @@ CirWriteCmd::help() const
         << "write the netlist to an ASCII AIG file (.aag)\n";
 }
 
+
+//----------------------------------------------------------------------
+//    CIRSAVE <(string snapFile)>
+//----------------------------------------------------------------------
+CmdExecStatus
+CirSaveCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token, false))
+      return CMD_EXEC_ERROR;
+
+   ofstream outfile(token.c_str(), ios::out | ios::binary);
+   if (!outfile)
+      return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, token);
+   cirMgr->saveSnapshot(outfile, curCmd);
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirSaveCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRSAVE <(string snapFile)>" << endl;
+}
+
+void
+CirSaveCmd::help() const
+{
+   cout << setw(15) << left << "CIRSAVE: "
+        << "save the circuit and its simulation state to a binary snapshot\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRLOAD <(string snapFile)> [-Replace]
+//----------------------------------------------------------------------
+CmdExecStatus
+CirLoadCmd::exec(const string& option)
+{
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   bool doReplace = false;
+   string fileName;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Replace", options[i], 2) == 0) {
+         if (doReplace) return CmdExec::errorOption(CMD_OPT_EXTRA,options[i]);
+         doReplace = true;
+      }
+      else {
+         if (fileName.size())
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         fileName = options[i];
+      }
+   }
+
+   if (cirMgr != 0) {
+      if (doReplace) {
+         cerr << "Note: original circuit is replaced..." << endl;
+         curCmd = CIRINIT;
+         delete cirMgr; cirMgr = 0;
+      }
+      else {
+         cerr << "Error: circuit already exists!!" << endl;
+         return CMD_EXEC_ERROR;
+      }
+   }
+   cirMgr = new CirMgr;
+
+   unsigned state = CIRINIT;
+   if (!cirMgr->loadSnapshot(fileName, state) || state == CIRINIT || state >= CIRCMDTOT) {
+      curCmd = CIRINIT;
+      delete cirMgr; cirMgr = 0;
+      return CMD_EXEC_ERROR;
+   }
+
+   curCmd = (CirCmdState)state;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirLoadCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRLOAD <(string snapFile)> [-Replace]" << endl;
+}
+
+void
+CirLoadCmd::help() const
+{
+   cout << setw(15) << left << "CIRLOAD: "
+        << "restore a circuit from a binary snapshot\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRCHeck <(string proofFile)>
+//----------------------------------------------------------------------
+CmdExecStatus
+CirCheckCmd::exec(const string& option)
+{
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token, false))
+      return CMD_EXEC_ERROR;
+
+   ProofChecker checker;
+   if (!SatSolver::checkProof(token, checker)) {
+      cerr << "Error: \"" << token << "\" is not a valid proof file!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   cout << "Proof: " << checker.roots << " root, " << checker.chains << " derived, "
+        << checker.deletions << " deleted clauses" << endl;
+   cout << "       " << checker.queries << " UNSAT queries, " << checker.merges << " merges" << endl;
+   if (!checker.complete) {
+      cerr << "Error: \"" << token << "\" is corrupt or truncated!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   if (checker.bad) {
+      cout << "Error: " << checker.bad << " invalid resolution chain(s), first at clause "
+           << checker.first_bad << "!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   if (checker.unproven) {
+      cout << "Error: " << checker.unproven << " merge(s) without a valid refutation, first ("
+           << checker.first_x << ", " << checker.first_y << ")!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // The root clauses (the CNF of the circuit) are taken as given
+   cout << "All resolution chains are valid; every merge follows from the root clauses." << endl;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirCheckCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRCHeck <(string proofFile)>" << endl;
+}
+
+void
+CirCheckCmd::help() const
+{
+   cout << setw(15) << left << "CIRCHeck: "
+        << "replay a fraig proof and check its resolutions and merges\n";
+}
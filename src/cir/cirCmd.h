@@ -17,8 +17,14 @@ CmdClass(CirGateCmd);
 CmdClass(CirSweepCmd);
 CmdClass(CirOptCmd);
 CmdClass(CirStrashCmd);
+CmdClass(CirRewriteCmd);
+CmdClass(CirBalanceCmd);
+CmdClass(CirResubCmd);
 CmdClass(CirSimCmd);
 CmdClass(CirFraigCmd);
 CmdClass(CirWriteCmd);
+CmdClass(CirSaveCmd);
+CmdClass(CirLoadCmd);
+CmdClass(CirCheckCmd);
 
 #endif // CIR_CMD_H
@@ -0,0 +1,170 @@
+/****************************************************************************
+  FileName     [ cirCut.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define k-feasible cut enumeration over the AIG ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2014 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <algorithm>
+#include "cirCut.h"
+#include "cirGate.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static const CutTruth cutVarTruth[CUT_MAX_LEAF] = {
+   0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+   0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+};
+
+static inline unsigned signCount(CutTruth s)
+{
+   unsigned n = 0;
+   for (; s; s &= s - 1) ++n;
+   return n;
+}
+
+// Exchange variables v and v + 1 of "t"
+static inline CutTruth swapAdjacent(CutTruth t, unsigned v)
+{
+   CutTruth up   = cutVarTruth[v] & ~cutVarTruth[v + 1];   // x_v = 1, x_v+1 = 0
+   CutTruth down = ~cutVarTruth[v] & cutVarTruth[v + 1];   // x_v = 0, x_v+1 = 1
+   unsigned shift = 1u << v;
+   return (t & ~(up | down)) | ((t & up) << shift) | ((t & down) >> shift);
+}
+
+// Smaller cuts first; ties broken by the leaves to keep runs reproducible
+static bool cutLess(const CirCut& a, const CirCut& b)
+{
+   if (a.size() != b.size()) return a.size() < b.size();
+   for (unsigned i = 0; i < a.size(); ++i)
+      if (a[i] != b[i]) return a[i] < b[i];
+   return false;
+}
+
+/****************************************/
+/*   class CirCutMgr member functions   */
+/****************************************/
+CutTruth
+CirCutMgr::varTruth(unsigned i)
+{
+   assert(i < CUT_MAX_LEAF);
+   return cutVarTruth[i];
+}
+
+void
+CirCutMgr::compute(const GateList& dfsList, size_t gateNum, unsigned k, unsigned maxCuts)
+{
+   assert(k >= 2 && k <= CUT_MAX_LEAF && maxCuts >= 2);
+   _k = k; _maxCuts = maxCuts;
+   _cuts.assign(gateNum * maxCuts, CirCut());
+   _cutNum.assign(gateNum, 0);
+   for (size_t i = 0; i < dfsList.size(); ++i)
+      if (dfsList[i] && dfsList[i]->getType() != PO_GATE)
+         computeNode(dfsList[i]);
+}
+
+void
+CirCutMgr::computeNode(CirGate* gate)
+{
+   unsigned id = gate->getGateID();
+   CirCut* slot = &_cuts[id * _maxCuts];
+   // The constant has only the empty cut
+   if (gate->getType() == CONST_GATE) {
+      slot[0] = CirCut(); _cutNum[id] = 1;
+      return;
+   }
+   CirCut trivial;
+   trivial._leaves[0] = id; trivial._size = 1;
+   trivial._sign = (CutTruth)1 << (id & 63);
+   trivial._truth = cutVarTruth[0];
+   slot[0] = trivial; _cutNum[id] = 1;
+   if (gate->getType() != AIG_GATE) return;
+
+   CirGate* in0 = gate->getInput0(); CirGate* in1 = gate->getInput1();
+   unsigned id0 = in0->getGateID(), id1 = in1->getGateID();
+   unsigned n0 = cutNum(id0), n1 = cutNum(id1);
+   CutTruth inv0 = gate->getisInv0() ? ~(CutTruth)0 : 0;
+   CutTruth inv1 = gate->getisInv1() ? ~(CutTruth)0 : 0;
+   _cands.clear();
+   for (unsigned i = 0; i < n0; ++i) {
+      const CirCut& c0 = getCut(id0, i);
+      for (unsigned j = 0; j < n1; ++j) {
+         const CirCut& c1 = getCut(id1, j);
+         if (signCount(c0._sign | c1._sign) > _k) continue;
+         CirCut cut;
+         if (!mergeLeaves(c0, c1, cut)) continue;
+         cut._truth = stretch(c0._truth ^ inv0, c0, cut) & stretch(c1._truth ^ inv1, c1, cut);
+         addCand(cut);
+      }
+   }
+   // Keep the best ones behind the trivial cut
+   sort(_cands.begin(), _cands.end(), cutLess);
+   for (size_t i = 0; i < _cands.size() && _cutNum[id] < _maxCuts; ++i)
+      slot[_cutNum[id]++] = _cands[i];
+}
+
+// Union of the (sorted) leaves; false if it has more than _k of them
+bool
+CirCutMgr::mergeLeaves(const CirCut& a, const CirCut& b, CirCut& out) const
+{
+   unsigned i = 0, j = 0, n = 0;
+   while (i < a._size || j < b._size) {
+      if (n == _k) return false;
+      if (j == b._size || (i < a._size && a._leaves[i] < b._leaves[j]))
+         out._leaves[n++] = a._leaves[i++];
+      else if (i == a._size || b._leaves[j] < a._leaves[i])
+         out._leaves[n++] = b._leaves[j++];
+      else { out._leaves[n++] = a._leaves[i++]; ++j; }
+   }
+   out._size = n;
+   out._sign = a._sign | b._sign;
+   return true;
+}
+
+// True if the leaves of "a" are a subset of those of "b"
+bool
+CirCutMgr::dominates(const CirCut& a, const CirCut& b) const
+{
+   if (a._size > b._size || (a._sign & ~b._sign)) return false;
+   unsigned j = 0;
+   for (unsigned i = 0; i < a._size; ++i) {
+      while (j < b._size && b._leaves[j] < a._leaves[i]) ++j;
+      if (j == b._size || b._leaves[j] != a._leaves[i]) return false;
+   }
+   return true;
+}
+
+// Add "cut" unless a candidate dominates it; drop the ones it dominates
+bool
+CirCutMgr::addCand(const CirCut& cut)
+{
+   for (size_t i = 0; i < _cands.size(); ++i)
+      if (dominates(_cands[i], cut)) return false;
+   size_t n = 0;
+   for (size_t i = 0; i < _cands.size(); ++i)
+      if (!dominates(cut, _cands[i])) _cands[n++] = _cands[i];
+   _cands.resize(n);
+   _cands.push_back(cut);
+   return true;
+}
+
+// Re-express "t" over the leaves of "from" as a table over those of "to"
+// (a superset): move each variable up to its new position, top ones first
+CutTruth
+CirCutMgr::stretch(CutTruth t, const CirCut& from, const CirCut& to)
+{
+   unsigned pos[CUT_MAX_LEAF];
+   for (unsigned i = 0, j = 0; i < from._size; ++i) {
+      while (to._leaves[j] != from._leaves[i]) ++j;
+      pos[i] = j;
+   }
+   for (int i = (int)from._size - 1; i >= 0; --i)
+      for (unsigned v = (unsigned)i; v < pos[i]; ++v)
+         t = swapAdjacent(t, v);
+   return t;
+}
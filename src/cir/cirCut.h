@@ -0,0 +1,88 @@
+/****************************************************************************
+  FileName     [ cirCut.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define k-feasible cut enumeration over the AIG ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2014 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_CUT_H
+#define CIR_CUT_H
+
+#include <vector>
+#include "cirDef.h"
+
+using namespace std;
+
+// A cut of a node is a set of at most 6 gates (the leaves, sorted by ID)
+// that separates it from the PIs; its truth table over the leaves is kept
+// in 64 bits, leaf i being the variable with minterm bits 0xAAAA... for
+// i = 0, 0xCCCC... for i = 1, and so on (tables of fewer leaves repeat).
+// Each node keeps its trivial cut and the best "maxCuts - 1" others, all
+// in one array with a fixed slot range per gate ID.
+
+#define CUT_MAX_LEAF 6
+
+typedef unsigned long long CutTruth;
+
+/*******************************/
+/*   CirCut class declaration  */
+/*******************************/
+class CirCut
+{
+public:
+   CirCut(): _size(0), _sign(0), _truth(0) {}
+
+   unsigned size() const { return _size; }
+   unsigned operator [] (unsigned i) const { return _leaves[i]; }
+   CutTruth getTruth() const { return _truth; }
+   // Bit (ID % 64) of every leaf; a cut can only contain another one if
+   // it contains its signature
+   CutTruth getSign() const { return _sign; }
+
+private:
+   friend class CirCutMgr;
+
+   unsigned       _leaves[CUT_MAX_LEAF];
+   unsigned       _size;
+   CutTruth       _sign;
+   CutTruth       _truth;
+};
+
+/**********************************/
+/*   CirCutMgr class declaration  */
+/**********************************/
+class CirCutMgr
+{
+public:
+   CirCutMgr(): _k(4), _maxCuts(8) {}
+   ~CirCutMgr() {}
+
+   // Enumerate the cuts of every gate of "dfsList" (fanins first); gate
+   // IDs must be below "gateNum". A node reads only its fanins' cuts and
+   // writes only its own slots, so nodes of one level may run in parallel
+   void compute(const GateList& dfsList, size_t gateNum, unsigned k = 4, unsigned maxCuts = 8);
+   void clear() { _cuts.clear(); _cutNum.clear(); }
+
+   unsigned cutNum(unsigned id) const { return id < _cutNum.size() ? _cutNum[id] : 0; }
+   const CirCut& getCut(unsigned id, unsigned i) const { return _cuts[id * _maxCuts + i]; }
+   unsigned getK() const { return _k; }
+
+   // Truth table of leaf "i"
+   static CutTruth varTruth(unsigned i);
+
+private:
+   unsigned          _k;
+   unsigned          _maxCuts;
+   vector<CirCut>    _cuts;       // slots [id * _maxCuts, (id + 1) * _maxCuts)
+   vector<unsigned>  _cutNum;
+   vector<CirCut>    _cands;      // scratch of computeNode()
+
+   void computeNode(CirGate*);
+   bool mergeLeaves(const CirCut&, const CirCut&, CirCut&) const;
+   bool dominates(const CirCut&, const CirCut&) const;
+   bool addCand(const CirCut&);
+   static CutTruth stretch(CutTruth, const CirCut&, const CirCut&);
+};
+
+#endif // CIR_CUT_H
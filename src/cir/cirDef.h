@@ -36,4 +36,16 @@ enum GateType
    TOT_GATE
 };
 
+// Word "w" of input "i" when all combinations of the inputs are counted
+// through consecutive 64-bit words (bit k of word w is combination
+// 64 * w + k)
+inline size_t cirVarWord(size_t i, size_t w)
+{
+   static const size_t mask[6] = {
+      (size_t)0xAAAAAAAAAAAAAAAAULL, (size_t)0xCCCCCCCCCCCCCCCCULL, (size_t)0xF0F0F0F0F0F0F0F0ULL,
+      (size_t)0xFF00FF00FF00FF00ULL, (size_t)0xFFFF0000FFFF0000ULL, (size_t)0xFFFFFFFF00000000ULL };
+   if (i < 6) return mask[i];
+   return ((w >> (i - 6)) & 1) ? ~(size_t)0 : 0;
+}
+
 #endif // CIR_DEF_H
\ No newline at end of file
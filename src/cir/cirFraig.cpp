@@ -18,6 +18,20 @@ using namespace std;
 // TODO: Please keep "CirMgr::strash()" and "CirMgr::fraig()" for cir cmd.
 //       Feel free to define your own variables or functions
 
+#define EXACT_SUPPORT_LIMIT 16     // 2^16 patterns: 1024 words per gate
+#define EXACT_CONE_LIMIT    4096   // Larger cones cost more than a query
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// Cone marks of solveExact(): a gate is in the current cone if its mark
+// equals exStamp; exPos is then its position in the cone. A gate whose
+// exOpen equals exStamp but whose mark does not is still on the stack
+static vector<unsigned> exMark;
+static vector<unsigned> exOpen;
+static vector<unsigned> exPos;
+static unsigned exStamp = 0;
+
 /************************************/
 /*   HashKey class implementation   */
 /************************************/
@@ -55,60 +69,128 @@ private:
 void
 CirMgr::strash()
 {
-	if (_dfsList.size() == 0) cirDFSearch();
-	bool resetDFSList = false;
+	cirDFSFresh();
+	CirGate::setGlobalRef();
 	HashMap<StrashKey, CirGate*>* cirStrHash = new HashMap<StrashKey, CirGate*>;
 	for (size_t i = 0; i < _dfsList.size(); ++i) {
+		_dfsList[i]->setToGlobalRef();
 		StrashKey tempKey(_dfsList[i]); CirGate* merGate = 0;
 		if (_dfsList[i]->getTypeStr() == "AIG") {
 			if (cirStrHash->check(tempKey, merGate)) {
 				gateMerge(merGate, _dfsList[i], false);
+				dfsMerge(merGate, _dfsList[i]);
 				cout << "Strashing: " << merGate->getGateID() << " merging " << _dfsList[i]->getGateID() << "..." << endl;
 				if (_dfsList[i]->getTypeStr() == "AIG") --_aigNum;
 				_totList[_dfsList[i]->getGateID()] = 0;
-				resetDFSList = true;
 			}
 			else cirStrHash->forceInsert(tempKey, _dfsList[i]);
 		}
 	}
 	delete cirStrHash; cirStrHash = 0;
 	
-	if (resetDFSList) { _dfsList.resize(0); cirDFSearch(); }
+	cirDFSUpdate();
 }
 
 void
-CirMgr::fraig()
+CirMgr::fraig(bool circuitSat)
 {
-	if (_dfsList.size() == 0) cirDFSearch();
-	_solver.initialize();
-	genProofModel();
+	_circuitSat = circuitSat;
+	_csat.clearStats();
+	cirDFSFresh();
+	// Exact groups are merged as they are, unless each merge needs a proof
+	if (_solver.hasProof()) _fecProven = false;
+	if (!_fecProven) {
+		_solver.initialize();
+		_solver.setRace(_raceNum, _raceBudget);
+		genProofModel();
+	}
 	solveFECPairs();
 	fecGroNumReset();
 	_fecGroSize = 0;
 	_fecGroups.resize(0);
+	_fecProven = false;
+	if (_circuitSat) _csat.printStats();
 	strash();
 }
 
+// Log the resolution proofs of the following fraig runs ("" to stop)
+bool
+CirMgr::setProof(const string& fileName)
+{
+	return _solver.setProof(fileName);
+}
+
+// Race the hard queries of the following fraig runs on "racers" solvers,
+// once one has spent "budget" conflicts (1 racer: solve them alone)
+void
+CirMgr::setRace(int racers, int budget)
+{
+	_raceNum = racers;
+	_raceBudget = budget;
+}
+
 /********************************************/
 /*   Private member functions about fraig   */
 /********************************************/
 void
 CirMgr::genProofModel()
 {
+	// Forget the variables of an earlier model; only gates listed now get one
+	for (size_t i = 0; i < _totList.size(); ++i)
+		if (_totList[i]) _totList[i]->setVar(var_Undef);
+	if (_circuitSat) { genCircuitModel(); return; }
 	Var v0 = _solver.newVar();
 	_totList[0]->setVar(v0);
 	for (size_t i = 0; i < _dfsList.size(); ++i) {
-		Var v = _solver.newVar();
-		_dfsList[i]->setVar(v);
-      if (_dfsList[i]->getTypeStr() == "AIG") {
-      	bool inv0 = _dfsList[i]->getisInv0(); CirGate* inGate0 = _dfsList[i]->getInput0();
-      	if (_dfsList[i]->getInput1()) {
-      		bool inv1 = _dfsList[i]->getisInv1(); CirGate* inGate1 = _dfsList[i]->getInput1();
-      		_solver.addAigCNF(_dfsList[i]->getVar(), inGate0->getVar(), inv0, inGate1->getVar(), inv1);
-      	}
-      	else _solver.addAigCNF(_dfsList[i]->getVar(), inGate0->getVar(), inv0, inGate0->getVar(), inv0);
-      }
-   }
+		// A fanin listed after its fanout (a merge closed a loop) gets its
+		// variable when the fanout is reached
+		if (_dfsList[i]->getVar() == var_Undef || _dfsList[i] == _totList[0]) _dfsList[i]->setVar(_solver.newVar());
+		Var v = _dfsList[i]->getVar();
+		// Start from the first simulated pattern: a consistent assignment of the whole circuit
+		_solver.setPhase(v, _dfsList[i]->getGateValue() & 1);
+		if (_dfsList[i]->getTypeStr() == "AIG") {
+			CirGate* inGate0 = _dfsList[i]->getInput0();
+			CirGate* inGate1 = _dfsList[i]->getInput1() ? _dfsList[i]->getInput1() : inGate0;
+			bool inv1 = _dfsList[i]->getInput1() ? _dfsList[i]->getisInv1() : _dfsList[i]->getisInv0();
+			if (inGate0->getVar() == var_Undef) inGate0->setVar(_solver.newVar());
+			if (inGate1->getVar() == var_Undef) inGate1->setVar(_solver.newVar());
+			_solver.addAigCNF(v, inGate0->getVar(), _dfsList[i]->getisInv0(), inGate1->getVar(), inv1);
+		}
+	}
+	// Unused PIs still take part in the counter-examples
+	for (size_t i = 0; i < _piList.size(); ++i)
+		if (_piList[i]->getVar() == var_Undef) _piList[i]->setVar(_solver.newVar());
+	// Only the FEC candidates get later clauses; every other variable may be
+	// resolved away (its model value is rebuilt)
+	_solver.assertProperty(_totList[0]->getVar(), false);
+	for (size_t i = 0; i < _dfsList.size(); ++i)
+		if (_dfsList[i]->getGroNum() != -1) _solver.freezeVar(_dfsList[i]->getVar());
+	_solver.preprocess();
+}
+
+void
+CirMgr::genCircuitModel()
+{
+	// The same variables index the nodes of the circuit solver; no CNF is built
+	_csat.reset();
+	_totList[0]->setVar(_csat.newNode());
+	for (size_t i = 0; i < _dfsList.size(); ++i) {
+		// As in genProofModel(), a fanin over a loop is numbered on demand
+		if (_dfsList[i]->getVar() == var_Undef || _dfsList[i] == _totList[0]) _dfsList[i]->setVar(_csat.newNode());
+		Var v = _dfsList[i]->getVar();
+		_csat.setPhase(v, _dfsList[i]->getGateValue() & 1);
+		if (_dfsList[i]->getTypeStr() == "AIG") {
+			CirGate* inGate0 = _dfsList[i]->getInput0();
+			CirGate* inGate1 = _dfsList[i]->getInput1() ? _dfsList[i]->getInput1() : inGate0;
+			bool inv1 = _dfsList[i]->getInput1() ? _dfsList[i]->getisInv1() : _dfsList[i]->getisInv0();
+			if (inGate0->getVar() == var_Undef) inGate0->setVar(_csat.newNode());
+			if (inGate1->getVar() == var_Undef) inGate1->setVar(_csat.newNode());
+			_csat.addAnd(v, inGate0->getVar(), _dfsList[i]->getisInv0(), inGate1->getVar(), inv1);
+		}
+	}
+	for (size_t i = 0; i < _piList.size(); ++i)
+		if (_piList[i]->getVar() == var_Undef) _piList[i]->setVar(_csat.newNode());
+	_csat.assertNode(_totList[0]->getVar(), false);
 }
 
 void
@@ -128,46 +210,69 @@ CirMgr::solveFECPairs()
 				++round;
 				repeat = false;
 			}
-		if (!result) { _dfsList.resize(0); cirDFSearch(); _solver.initialize(); genProofModel(); }
+		if (!result) { cirDFSUpdate(); if (!_fecProven) { _solver.initialize(); genProofModel(); } }
 		valPISim(simPattern, _piList); cirFileSim();
 		fecReCheck(false, true, result);
 		solveDFSList(simPattern, round, result);
 	}
+	cirDFSUpdate();
 }
 
 void
 CirMgr::solveDFSList(vector<size_t>& simPattern, size_t& round, bool& result)
 {
+	// Each FEC group is handed to the solver as one batch when the scan
+	// reaches its first candidate; the results are consumed in DFS order
+	vector<size_t> dfsPos(_totList.size(), (size_t)-1);
+	for (size_t i = 0; i < _dfsList.size(); ++i)
+		if (_dfsList[i]) dfsPos[_dfsList[i]->getGateID()] = i;
+	vector<bool> batched(_fecGroups.size(), false);
+	vector<size_t> pairOf(_totList.size(), (size_t)-1);
+	vector<SatPairResult> results;
+	CirGate::setGlobalRef();
 	for (size_t i = 0; i < _dfsList.size(); ++i) {
-		if (!_dfsList[i]) continue;
+		if (!_dfsList[i] || !_dfsList[i]->isInDFS()) continue;
+		_dfsList[i]->setToGlobalRef();
 		if (round == 32) break;
 		string type = _dfsList[i]->getTypeStr();
 		int groNum  = _dfsList[i]->getGroNum();
 		size_t thisID = _dfsList[i]->getGateID();
 		bool hasChecked = _dfsList[i]->hasFraiged();
-		if (groNum != -1 && type != "PI" && type != "PO" && !hasChecked && _totList[thisID] && _totList[_fecGroups[groNum][0]] && _totList[_fecGroups[groNum][0]]->getGateID() != thisID) {
-			Var newV = _solver.newVar();
+		// A leader left dangling before the model was rebuilt has no variable in it
+		if (groNum != -1 && type != "PI" && type != "PO" && !hasChecked && _totList[thisID] && _totList[_fecGroups[groNum][0]] && _totList[_fecGroups[groNum][0]]->getGateID() != thisID && (_fecProven || (_totList[_fecGroups[groNum][0]]->getVar() != var_Undef && _dfsList[i]->getVar() != var_Undef))) {
 			_totList[_fecGroups[groNum][0]]->setFraiged(true);
 			CirGate* leadGate = _totList[_fecGroups[groNum][0]];
 			size_t leadID = leadGate->getGateID();
 			bool isInv = (_dfsList[i]->getGateValue() == leadGate->getGateValue() ? false : true);
 			string tmp = (isInv ? "!" : "");
-			_solver.addXorCNF(newV, leadGate->getVar(), false, _dfsList[i]->getVar(), isInv);
-			_solver.assumeRelease();
-			_solver.assumeProperty(_totList[0]->getVar(), false);
-			_solver.assumeProperty(newV, true);
-			if (!_solver.assumpSolve()) {
+			if (!_circuitSat && !_fecProven && !batched[groNum]) {
+				batched[groNum] = true;
+				solveFECGroup(leadGate, (size_t)groNum, i, dfsPos, pairOf, results, 32 - round);
+			}
+			// Batched pairs have tried solveExact() already
+			SatPairStatus status = SAT_PAIR_UNTRIED;
+			vector<int> model;
+			if (_fecProven) status = SAT_PAIR_EQUIV;
+			else if (pairOf[thisID] != (size_t)-1) { status = results[pairOf[thisID]].status; model = results[pairOf[thisID]].model; }
+			else status = solveExact(leadGate, _dfsList[i], isInv, model);
+			if (status == SAT_PAIR_UNTRIED)
+				status = solveFEC(leadGate, _dfsList[i], isInv) ? SAT_PAIR_DIFF : SAT_PAIR_EQUIV;
+			if (status == SAT_PAIR_EQUIV) {
+				_solver.logMerge(leadID, thisID, leadGate->getVar(), _dfsList[i]->getVar(), isInv);
 				gateMerge(leadGate, _dfsList[i], isInv);
+				if (dfsMerge(leadGate, _dfsList[i])) ++i;
 				proveMessage(leadID, thisID, isInv, false);
 				cout << "Fraig: " << leadID << " merging " << tmp << thisID << "..." << endl;
 				if (type == "AIG") --_aigNum;
 				_totList[thisID] = 0;
 				result = false;
 			}
-			else {
+			else if (status == SAT_PAIR_DIFF) {
 				proveMessage(leadID, thisID, isInv, true);
 				for (size_t j = 0; j < _piList.size(); ++j) {
-					int bit = _solver.getValue(_piList[j]->getVar());
+					int bit;
+					if (!model.empty()) bit = model[j];
+					else bit = _circuitSat ? _csat.getValue(_piList[j]->getVar()) : _solver.getValue(_piList[j]->getVar());
 					if (bit == -1) bit = rand() % 2;
 					simPattern[j] |= ((size_t)bit << round);
 				}
@@ -177,6 +282,152 @@ CirMgr::solveDFSList(vector<size_t>& simPattern, size_t& round, bool& result)
 	}
 }
 
+// Solve the members of FEC group "groNum" from DFS position "from" on
+// against "leadGate" in one batch; "pairOf" maps a member to its result
+void
+CirMgr::solveFECGroup(CirGate* leadGate, size_t groNum, size_t from, const vector<size_t>& dfsPos, vector<size_t>& pairOf, vector<SatPairResult>& results, size_t satLimit)
+{
+	vector<SatPair> pairs;
+	vector<size_t> ids;
+	const intIdList& group = _fecGroups[groNum];
+	for (size_t k = 1; k < group.size(); ++k) {
+		if (group[k] < 0) continue;
+		CirGate* gate = _totList[group[k]];
+		if (!gate || gate == leadGate || !gate->isInDFS() || gate->hasFraiged() || gate->getVar() == var_Undef) continue;
+		size_t pos = dfsPos[gate->getGateID()];
+		if (pos == (size_t)-1 || pos < from) continue;
+		string type = gate->getTypeStr();
+		if (type == "PI" || type == "PO") continue;
+		bool isInv = (gate->getGateValue() != leadGate->getGateValue());
+		// Small cones are decided here and never reach the solver
+		SatPairResult exact;
+		exact.status = solveExact(leadGate, gate, isInv, exact.model);
+		if (exact.status != SAT_PAIR_UNTRIED) {
+			pairOf[gate->getGateID()] = results.size();
+			results.push_back(exact);
+			continue;
+		}
+		pairs.push_back(SatPair(leadGate->getVar(), gate->getVar(), isInv, pos));
+		ids.push_back(gate->getGateID());
+	}
+	vector<Var> piVars(_piList.size());
+	for (size_t j = 0; j < _piList.size(); ++j)
+		piVars[j] = _piList[j]->getVar();
+	vector<SatPairResult> batch;
+	_solver.solveBatch(pairs, piVars, batch, -1, satLimit);
+	for (size_t k = 0; k < ids.size(); ++k) {
+		pairOf[ids[k]] = results.size();
+		results.push_back(batch[k]);
+	}
+}
+
+// Decide "gate" == "leadGate" (inverted if "isInv") by simulating both
+// cones over all combinations of their support, without the solver; if
+// they differ, "model" gets a distinguishing input (-1: don't care).
+// SAT_PAIR_UNTRIED if the support or the cone is too large, or if the
+// proof log needs the query
+SatPairStatus
+CirMgr::solveExact(CirGate* leadGate, CirGate* gate, bool isInv, vector<int>& model)
+{
+	if (_solver.hasProof()) return SAT_PAIR_UNTRIED;
+	if (exMark.size() < _totList.size()) {
+		exMark.resize(_totList.size(), 0); exOpen.resize(_totList.size(), 0); exPos.resize(_totList.size(), 0);
+	}
+	if (++exStamp == 0) { exMark.assign(exMark.size(), 0); exOpen.assign(exOpen.size(), 0); exStamp = 1; }
+	// Both cones in topological order; "sup" is the input number of a PI
+	GateList cone; vector<size_t> sup;
+	size_t supNum = 0;
+	GateList stack;
+	stack.push_back(gate); stack.push_back(leadGate);
+	while (!stack.empty()) {
+		CirGate* g = stack.back();
+		unsigned id = g->getGateID();
+		if (exMark[id] == exStamp) { stack.pop_back(); continue; }
+		// First visit: push the fanins; one still on the stack closes a loop
+		if (g->getType() == AIG_GATE && exOpen[id] != exStamp) {
+			exOpen[id] = exStamp;
+			CirGate* in[2] = { g->getInput0(), g->getInput1() };
+			for (size_t k = 0; k < 2; ++k) {
+				if (!in[k]) return SAT_PAIR_UNTRIED;
+				unsigned inID = in[k]->getGateID();
+				if (exMark[inID] == exStamp) continue;
+				if (exOpen[inID] == exStamp) return SAT_PAIR_UNTRIED;
+				stack.push_back(in[k]);
+			}
+			if (stack.size() > EXACT_CONE_LIMIT) return SAT_PAIR_UNTRIED;
+			continue;
+		}
+		stack.pop_back();
+		exMark[id] = exStamp; exPos[id] = cone.size();
+		cone.push_back(g);
+		sup.push_back(g->getType() == PI_GATE ? supNum++ : 0);
+		if (supNum > EXACT_SUPPORT_LIMIT || cone.size() > EXACT_CONE_LIMIT) return SAT_PAIR_UNTRIED;
+	}
+	size_t words = supNum > 6 ? ((size_t)1 << (supNum - 6)) : 1;
+	size_t pol = isInv ? ~(size_t)0 : 0;
+	vector<size_t> val(cone.size(), 0);
+	for (size_t w = 0; w < words; ++w) {
+		for (size_t k = 0; k < cone.size(); ++k) {
+			CirGate* g = cone[k];
+			if (g->getType() == PI_GATE) val[k] = cirVarWord(sup[k], w);
+			else if (g->getType() == AIG_GATE)
+				val[k] = (val[exPos[g->getInput0()->getGateID()]] ^ (g->getisInv0() ? ~(size_t)0 : 0))
+				       & (val[exPos[g->getInput1()->getGateID()]] ^ (g->getisInv1() ? ~(size_t)0 : 0));
+			else val[k] = 0;
+		}
+		size_t diff = val[exPos[leadGate->getGateID()]] ^ val[exPos[gate->getGateID()]] ^ pol;
+		if (!diff) continue;
+		// Input combination of the lowest differing bit
+		size_t bit = 0;
+		while (!((diff >> bit) & 1)) ++bit;
+		size_t comb = w * 64 + bit;
+		model.assign(_piList.size(), -1);
+		for (size_t j = 0; j < _piList.size(); ++j) {
+			unsigned id = _piList[j]->getGateID();
+			if (exMark[id] == exStamp) model[j] = (comb >> sup[exPos[id]]) & 1;
+		}
+		return SAT_PAIR_DIFF;
+	}
+	return SAT_PAIR_EQUIV;
+}
+
+// Return true if "gate" can differ from "leadGate" (inverted if "isInv")
+bool
+CirMgr::solveFEC(CirGate* leadGate, CirGate* gate, bool isInv)
+{
+	if (_circuitSat) {
+		// Leader at either value (the constant only at 0); the gate at the other one
+		vector<unsigned> assumps(2);
+		bool first = leadGate->getGateValue() & 1;
+		for (size_t k = 0; k < 2; ++k) {
+			bool val = (k == 0 ? first : !first);
+			if (val && leadGate == _totList[0]) continue;
+			assumps[0] = leadGate->getVar() * 2 + !val;
+			assumps[1] = gate->getVar() * 2 + (val ^ isInv);
+			if (_csat.solve(assumps)) return true;
+		}
+		return false;
+	}
+	// The miter lives for this query only; the constant is fixed in the model
+	Var act = _solver.addXorMiter(leadGate->getVar(), gate->getVar(), isInv);
+	boostQueryVars(leadGate, gate);
+	_solver.assumeRelease();
+	_solver.assumeProperty(act, true);
+	bool sat = _solver.assumpSolve();
+	if (!sat) _solver.logQuery(act, leadGate->getVar(), gate->getVar(), isInv);
+	_solver.disableMiter(act);
+	return sat;
+}
+
+void
+CirMgr::boostQueryVars(CirGate* leadGate, CirGate* gate)
+{
+	// Decide the pair and their fanins first, so search starts at the miter
+	CirGate* near[6] = { leadGate, gate, leadGate->getInput0(), leadGate->getInput1(), gate->getInput0(), gate->getInput1() };
+	for (size_t i = 0; i < 6; ++i)
+		if (near[i] && near[i]->getVar() != var_Undef) _solver.boostVar(near[i]->getVar(), i < 2 ? 2 : 1);
+}
+
 void
 CirMgr::proveMessage(size_t leadID, size_t thisID, bool isInv, bool sat)
 {
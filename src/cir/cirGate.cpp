@@ -32,6 +32,15 @@ extern CirMgr *cirMgr;
 /**************************************/
 unsigned CirGate::_globalRef = 0;
 
+// Stack frame of the fanin/fanout report traversals
+struct RptFrame
+{
+	RptFrame(CirGate* g, unsigned layer, bool isInv): _gate(g), _layer(layer), _isInv(isInv) {}
+	CirGate*   _gate;
+	unsigned   _layer;
+	bool       _isInv;
+};
+
 /**************************************/
 /*   class CirGate member functions   */
 /**************************************/
@@ -133,7 +142,14 @@ CirGate::reportFanout(int level)
 void 
 CirGate::preOrder(CirGate* n, unsigned layer, unsigned level, bool isInv) 
 {
-	if (n) {
+	// Explicit stack instead of recursion; children are pushed in reverse
+	// order so that they are printed in the same order as before.
+	vector<RptFrame> stack;
+	stack.push_back(RptFrame(n, layer, isInv));
+	while (!stack.empty()) {
+		n = stack.back()._gate; layer = stack.back()._layer; isInv = stack.back()._isInv;
+		stack.pop_back();
+		if (!n) continue;
 		string temp = "";
 		for (size_t i = 0; i < layer; ++i)
 			cout << "  ";
@@ -143,19 +159,15 @@ CirGate::preOrder(CirGate* n, unsigned layer, unsigned level, bool isInv)
 		if (!n->eqGlobalRef()) {
 			n->setToGlobalRef();
 			cout << endl;
-			if (level > layer && n->getTypeStr() == "PO") {
+			if (level > layer && n->getType() == PO_GATE) {
 				n->setToOpen();
-				isInv = n->getisInv0();
-				preOrder(n->getInput0(), layer, level, isInv);
+				stack.push_back(RptFrame(n->getInput0(), layer, n->getisInv0()));
 			}
-			else if (level > layer && n->getTypeStr() == "AIG") {
+			else if (level > layer && n->getType() == AIG_GATE) {
 				n->setToOpen();
-				bool isInv0 = n->getisInv0();
-				preOrder(n->getInput0(), layer, level, isInv0);
-				if (n->getInput1()) {
-					bool isInv1 = n->getisInv1();
-					preOrder(n->getInput1(), layer, level, isInv1);
-				}
+				if (n->getInput1())
+					stack.push_back(RptFrame(n->getInput1(), layer, n->getisInv1()));
+				stack.push_back(RptFrame(n->getInput0(), layer, n->getisInv0()));
 			}
 		}
 		else if (n->eqGlobalRef() && n->prevIsVisted() && n->isOpened() && level > layer)
@@ -167,7 +179,12 @@ CirGate::preOrder(CirGate* n, unsigned layer, unsigned level, bool isInv)
 void 
 CirGate::backPreOrder(CirGate* n, unsigned layer, unsigned level, bool isInv) 
 {
-	if (n) {
+	vector<RptFrame> stack;
+	stack.push_back(RptFrame(n, layer, isInv));
+	while (!stack.empty()) {
+		n = stack.back()._gate; layer = stack.back()._layer; isInv = stack.back()._isInv;
+		stack.pop_back();
+		if (!n) continue;
 		string temp = "";
 		for (size_t i = 0; i < layer; ++i)
 			cout << "  ";
@@ -180,11 +197,8 @@ CirGate::backPreOrder(CirGate* n, unsigned layer, unsigned level, bool isInv)
 			if (level > layer) {
 				n->setToOpen();
 				GateList tempOut = n->getOutput();
-				if (tempOut.size() == 0) return;
-				for (size_t i = 0; i < tempOut.size(); ++i) {
-					isInv = n->getOutInv(tempOut[i]);
-					backPreOrder(tempOut[i], layer, level, isInv);
-				}
+				for (size_t i = tempOut.size(); i > 0; --i)
+					stack.push_back(RptFrame(tempOut[i - 1], layer, n->getOutInv(tempOut[i - 1])));
 			}
 		}
 		else if (n->eqGlobalRef() && n->nextIsVisted() && n->isOpened() && level > layer)
@@ -193,6 +207,29 @@ CirGate::backPreOrder(CirGate* n, unsigned layer, unsigned level, bool isInv)
 	}
 }
 
+void
+CirGate::dfsTraverse(void (CirGate::*visit)())
+{
+	// Iterative post-order DFS; a gate is marked when it is first reached and
+	// visited after both of its fanins, exactly as the recursive version did.
+	vector<pair<CirGate*, unsigned> > stack;
+	this->setToGlobalRef();
+	stack.push_back(make_pair(this, 0u));
+	while (!stack.empty()) {
+		CirGate* g = stack.back().first; CirGate* next = 0;
+		while (stack.back().second < 2 && !next) {
+			CirGate* in = (stack.back().second == 0 ? g->getInput0() : g->getInput1());
+			++stack.back().second;
+			if (in && !in->eqGlobalRef()) next = in;
+		}
+		if (next) {
+			next->setToGlobalRef();
+			stack.push_back(make_pair(next, 0u));
+		}
+		else { (g->*visit)(); stack.pop_back(); }
+	}
+}
+
 bool 
 CirGate::prevIsVisted() 
 {
@@ -200,6 +237,15 @@ CirGate::prevIsVisted()
 	else return false;
 }
 
+// Count (d > 0) or release (d < 0) the fanin pins of a listed gate; kept
+// by setInDFS() and setInput(), so a gate whose count drops to 0 is dead
+void
+CirGate::refFanins(int d)
+{
+	if (this->getInput0()) this->getInput0()->_dfsRef += d;
+	if (this->getInput1()) this->getInput1()->_dfsRef += d;
+}
+
 bool 
 CirGate::nextIsVisted() 
 {
@@ -257,13 +303,9 @@ CirGate::myGNum2Str(int num)
 
 /* Searching functions */
 void
-CirAIGGate::gateDFSearch()
+CirAIGGate::dfsVisit()
 {
-	this->setToGlobalRef();
-	if (_aigIn0 && !_aigIn0->eqGlobalRef())
-		_aigIn0->gateDFSearch();
-	if (_aigIn1 && !_aigIn1->eqGlobalRef())
-		_aigIn1->gateDFSearch();
+	this->setInDFS(true);
 	cirMgr->_dfsList.push_back(this);
 }
 
@@ -271,8 +313,10 @@ CirAIGGate::gateDFSearch()
 void 
 CirAIGGate::setInput(CirGate* inGate0, bool phase0, CirGate* inGate1, bool phase1) 
 { 
+	if (this->isInDFS()) this->refFanins(-1);
 	this->setInv0(phase0); this->setInv1(phase1);
 	_aigIn0 = inGate0; _aigIn1 = inGate1;
+	if (this->isInDFS()) this->refFanins(1);
 }
 
 void 
@@ -283,13 +327,8 @@ CirAIGGate::removeOutput(CirGate* rmGate)
 
 /* Simulation functions */
 void
-CirAIGGate::gateSim()
+CirAIGGate::simVisit()
 {
-	this->setToGlobalRef();
-	if (_aigIn0 && !_aigIn0->eqGlobalRef())
-		_aigIn0->gateSim();
-	if (_aigIn1 && !_aigIn1->eqGlobalRef())
-		_aigIn1->gateSim();
 	this->setGateValue();
 }
 
@@ -299,9 +338,9 @@ CirAIGGate::gateSim()
 
 /* Searching functions */
 void
-CirPIGate::gateDFSearch()
+CirPIGate::dfsVisit()
 {
-	this->setToGlobalRef();
+	this->setInDFS(true);
 	cirMgr->_dfsList.push_back(this);
 }
 
@@ -314,9 +353,8 @@ CirPIGate::removeOutput(CirGate* rmGate)
 
 /* Simulation functions */
 void
-CirPIGate::gateSim()
+CirPIGate::simVisit()
 {
-	this->setToGlobalRef();
 }
 
 /****************************************/
@@ -325,11 +363,9 @@ CirPIGate::gateSim()
 
 /* Searching functions */
 void
-CirPOGate::gateDFSearch()
+CirPOGate::dfsVisit()
 {
-	this->setToGlobalRef();
-	if (_poIn && !_poIn->eqGlobalRef())
-		_poIn->gateDFSearch();
+	this->setInDFS(true);
 	cirMgr->_dfsList.push_back(this);
 }
 
@@ -337,19 +373,17 @@ CirPOGate::gateDFSearch()
 void 
 CirPOGate::setInput(CirGate* inGate0, bool phase0, CirGate* inGate1, bool phase1)
 { 
+	if (this->isInDFS()) this->refFanins(-1);
 	if (inGate0) { this->setInv0(phase0); _poIn = inGate0; }
 	else if (inGate1) { this->setInv1(phase1); _poIn = inGate1; }
+	if (this->isInDFS()) this->refFanins(1);
 }
 
 /* Simulation functions */
 void
-CirPOGate::gateSim()
+CirPOGate::simVisit()
 {
-	this->setToGlobalRef();
-	if (_poIn && !_poIn->eqGlobalRef())
-		_poIn->gateSim();
 	this->setGateValue();
-	cirMgr->_poValVec.push_back(this->getGateValue());
 }
 
 /*******************************************/
@@ -358,9 +392,9 @@ CirPOGate::gateSim()
 
 /* Searching functions */
 void
-CirUndefGate::gateDFSearch()
+CirUndefGate::dfsVisit()
 {
-	this->setToGlobalRef();
+	this->setInDFS(true);
 }
 
 /* Input & output functions */
@@ -372,9 +406,8 @@ CirUndefGate::removeOutput(CirGate* rmGate)
 
 /* Simulation functions */
 void
-CirUndefGate::gateSim()
+CirUndefGate::simVisit()
 {
-	this->setToGlobalRef();
 	this->setGateValueTo0();
 }
 
@@ -384,9 +417,9 @@ CirUndefGate::gateSim()
 
 /* Searching functions */
 void
-CirConstGate::gateDFSearch()
+CirConstGate::dfsVisit()
 {
-	this->setToGlobalRef();
+	this->setInDFS(true);
 	cirMgr->_dfsList.push_back(this);
 }
 
@@ -399,8 +432,7 @@ CirConstGate::removeOutput(CirGate* rmGate)
 
 /* Simulation functions */
 void
-CirConstGate::gateSim()
+CirConstGate::simVisit()
 {
-	this->setToGlobalRef();
 	this->setGateValueTo0();
 }
\ No newline at end of file
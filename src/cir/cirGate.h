@@ -36,7 +36,7 @@ public:
 	friend class cirMgr;
 	
    CirGate():
-   	_gateType(TOT_GATE), _lineNo(0), _gateID(0), _ref(0), _isOpened(0), _groNum(-1), _val(0), _var(0), _fraig(0) {}
+   	_gateType(TOT_GATE), _lineNo(0), _gateID(0), _ref(0), _isOpened(0), _groNum(-1), _val(0), _var(0), _fraig(0), _inDFS(0), _dfsRef(0) {}
    virtual ~CirGate() {}
 
    // Basic access methods
@@ -74,16 +74,22 @@ public:
    bool getOutInv(CirGate* out);
    
    // Searching functions
-   virtual void gateDFSearch() = 0;
+   void gateDFSearch() { dfsTraverse(&CirGate::dfsVisit); }
+   virtual void dfsVisit() = 0;
    void preOrder(CirGate*, unsigned, unsigned, bool);
    void backPreOrder(CirGate*, unsigned, unsigned, bool);
    bool prevIsVisted();
    bool nextIsVisted();
    void setToOpen() { _isOpened = _globalRef; }
    bool isOpened()  { return (_isOpened == _globalRef); }
+   void setInDFS(bool inDFS) { if (inDFS != _inDFS) refFanins(inDFS ? 1 : -1); _inDFS = inDFS; }
+   bool isInDFS() const { return _inDFS; }
+   bool hasDFSFanout() const { return _dfsRef != 0; }
+   void refFanins(int);
    
    // Simulation functions
-   virtual void gateSim() = 0;
+   void gateSim() { dfsTraverse(&CirGate::simVisit); }
+   virtual void simVisit() = 0;
    void setGroNum(int groNum) { _groNum = groNum; }
    int  getGroNum() { return _groNum; }
    
@@ -100,8 +106,11 @@ public:
    
    // Helper functions
    static string myGNum2Str(int); // Default base is 10
+   GateType getType() const { return _gateType; }
 
 protected:
+	void dfsTraverse(void (CirGate::*)());
+
 	GateType		_gateType;
 	unsigned		_lineNo;
 	unsigned		_gateID;
@@ -112,6 +121,8 @@ protected:
 	size_t			_val;
 	Var				_var;
 	bool			_fraig;
+	bool			_inDFS;   // reachable from a PO, i.e. listed in _dfsList
+	unsigned		_dfsRef;  // fanin pins of listed gates pointing here
 };
 
 class CirAIGGate: public CirGate
@@ -119,10 +130,10 @@ class CirAIGGate: public CirGate
 public:
 	friend class cirMgr;
 	
-	CirAIGGate(): _aigInv0(0), _aigInv1(0) { _gateType = AIG_GATE; }
+	CirAIGGate(): _aigIn0(0), _aigIn1(0), _aigInv0(0), _aigInv1(0) { _gateType = AIG_GATE; }
 	~CirAIGGate() {}
 	void printGate() const { cout << "AIG"; }
-	void gateDFSearch();
+	void dfsVisit();
 	void setInput(CirGate* inGate0, bool phase0, CirGate* inGate1, bool phase1);
 	void addOutput(CirGate* outGate) { _aigOut.push_back(outGate); }
 	void removeOutput(CirGate* rmGate);
@@ -134,7 +145,7 @@ public:
 	CirGate* getInput0() const { return _aigIn0; }
 	CirGate* getInput1() const { return _aigIn1; }
 	GateList getOutput() const { return _aigOut; }
-	void gateSim();
+	void simVisit();
 	void setSymbol(string symbol) {}
 	string getSymbol() const { return ""; }
 	
@@ -154,7 +165,7 @@ public:
 	CirPIGate(): _piSymbol("") { _gateType = PI_GATE; }
 	~CirPIGate() {}
 	void printGate() const { cout << "PI"; }
-	void gateDFSearch();
+	void dfsVisit();
 	void setInput(CirGate* inGate0, bool phase0, CirGate* inGate1, bool phase1) {}
 	void addOutput(CirGate* outGate) { _piOut.push_back(outGate); }
 	void removeOutput(CirGate* rmGate);
@@ -166,7 +177,7 @@ public:
 	CirGate* getInput0() const { return 0; }
 	CirGate* getInput1() const { return 0; }
 	GateList getOutput() const { return _piOut; }
-	void gateSim();
+	void simVisit();
 	void setSymbol(string symbol) { _piSymbol = symbol; }
 	string getSymbol() const { return _piSymbol; }
 
@@ -180,11 +191,11 @@ class CirPOGate: public CirGate
 public:
 	friend class cirMgr;
 	
-	CirPOGate(): _poInv(0), _poSymbol("") { _gateType = PO_GATE; }
+	CirPOGate(): _poIn(0), _poInv(0), _poSymbol("") { _gateType = PO_GATE; }
 	~CirPOGate() {}
 	void printGate() const { cout << "PO"; }
 	string getTypeStr() const { return "PO"; }
-	void gateDFSearch();
+	void dfsVisit();
 	void setInput(CirGate* inGate0, bool phase0, CirGate* inGate1, bool phase1);
 	void addOutput(CirGate* outGate) {}
 	void removeOutput(CirGate* rmGate) {}
@@ -196,7 +207,7 @@ public:
 	CirGate* getInput0() const { return _poIn; }
 	CirGate* getInput1() const { return 0; }
 	GateList getOutput() const { GateList temp; temp.resize(0); return temp; }
-	void gateSim();
+	void simVisit();
 	void setSymbol(string symbol) { _poSymbol = symbol; }
 	string getSymbol() const { return _poSymbol; }
 
@@ -214,7 +225,7 @@ public:
 	CirUndefGate() { _gateType = UNDEF_GATE; }
 	~CirUndefGate() {}
 	void printGate() const { cout << "UNDEF"; }
-	void gateDFSearch();
+	void dfsVisit();
 	void setInput(CirGate* inGate0, bool phase0, CirGate* inGate1, bool phase1) {}
 	void addOutput(CirGate* outGate) { _unOut.push_back(outGate); }
 	void removeOutput(CirGate* rmGate);
@@ -226,7 +237,7 @@ public:
 	CirGate* getInput0() const { return 0; }
 	CirGate* getInput1() const { return 0; }
 	GateList getOutput() const { return _unOut; }
-	void gateSim();
+	void simVisit();
 	void setSymbol(string symbol) {}
 	string getSymbol() const { return ""; }
 
@@ -242,7 +253,7 @@ public:
 	CirConstGate() { _gateType = CONST_GATE; }
 	~CirConstGate() {}
 	void printGate() const { cout << "CONST"; }
-	void gateDFSearch();
+	void dfsVisit();
 	void setInput(CirGate* inGate0, bool phase0, CirGate* inGate1, bool phase1) {}
 	void addOutput(CirGate* outGate) { _consOut.push_back(outGate); }
 	void removeOutput(CirGate* rmGate);
@@ -254,7 +265,7 @@ public:
 	CirGate* getInput0() const { return 0; }
 	CirGate* getInput1() const { return 0; }
 	GateList getOutput() const { return _consOut; }
-	void gateSim();
+	void simVisit();
 	void setSymbol(string symbol) {}
 	string getSymbol() const { return ""; }
 
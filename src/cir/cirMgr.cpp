@@ -729,7 +729,7 @@ CirMgr::printSummary() const
 void
 CirMgr::printNetlist()
 {
-	if (_dfsList.size() == 0)
+	if (_dfsStale)
 		cirDFSearch();
 	cout << endl;
 	for (unsigned i = 0; i < _dfsList.size(); ++i) {
@@ -847,7 +847,7 @@ CirMgr::printFECPairs() const
 void
 CirMgr::writeAag(ostream& outfile)
 {
-	if (_dfsList.size() == 0)
+	if (_dfsStale)
 		cirDFSearch();
 	unsigned aigDFSnum = 0;
 	vector<string> inputSymbol;
@@ -894,11 +894,79 @@ CirMgr::writeAag(ostream& outfile)
 void
 CirMgr::cirDFSearch()
 {
+	for (size_t i = 0; i < _dfsList.size(); ++i) _dfsList[i]->setInDFS(false);
+	for (size_t i = 0; i < _undefList.size(); ++i) _undefList[i]->setInDFS(false);
+	_dfsList.resize(0); _dfsHoles = 0; _dfsBroken = false; _dfsStale = false;
 	CirGate::setGlobalRef();
-	if (_poList.size() != 0)
-		for (unsigned i = 0; i < _poList.size(); ++i)
-			_poList[i]->gateDFSearch();
-	else return;
+	for (unsigned i = 0; i < _poList.size(); ++i)
+		_poList[i]->gateDFSearch();
+	_unlisted.resize(0);
+	for (size_t i = 0; i < _totList.size(); ++i)
+		if (_totList[i] && !_totList[i]->isInDFS()) _unlisted.push_back(_totList[i]);
+}
+
+void
+CirMgr::cirDFSUpdate()
+{
+	// Rebuild only if some merge broke the topological order;
+	// otherwise just drop the merged and dangling gates.
+	if (_dfsBroken) { cirDFSearch(); return; }
+	if (_dfsHoles == 0) return;
+	CirGate::setGlobalRef();
+	size_t n = 0;
+	for (size_t i = 0; i < _dfsList.size(); ++i)
+		if (_dfsList[i]->isInDFS() && !_dfsList[i]->eqGlobalRef()) {
+			_dfsList[i]->setToGlobalRef();
+			_dfsList[n++] = _dfsList[i];
+		}
+	_dfsList.resize(n); _dfsHoles = 0;
+}
+
+void
+CirMgr::cirDFSFresh()
+{
+	// Passes that pick a gate by its place in _dfsList (the kept one of two
+	// equal gates, a group leader) see the order a fresh DFS would give
+	if (_dfsList.size() == 0 || _dfsStale) cirDFSearch();
+}
+
+/*******************************************************************/
+/*   class CirMgr private member functions for circuit searching   */
+/*******************************************************************/
+bool
+CirMgr::dfsMerge(CirGate* inGate, CirGate* thisGate)
+{
+	/*   Called after gateMerge(inGate, thisGate) while scanning _dfsList;   */
+	/*   gates already scanned carry the current global ref.                 */
+	/*   Return true if inGate has been spliced in at the front of the list. */
+	bool spliced = false;
+	_dfsStale = true;
+	if (!inGate->isInDFS() && inGate->getType() == CONST_GATE) {
+		inGate->setInDFS(true); inGate->setToGlobalRef();
+		_dfsList.insert(_dfsList.begin(), inGate);
+		spliced = true;
+	}
+	else if (!inGate->isInDFS()) _dfsBroken = true;
+	else if (inGate->getType() != UNDEF_GATE && !inGate->eqGlobalRef()) _dfsBroken = true;
+	dfsRemove(thisGate);
+	return spliced;
+}
+
+void
+CirMgr::dfsRemove(CirGate* gate)
+{
+	/*   Unlist gate, then every fanin left without a listed fanout   */
+	GateList stack(1, gate);
+	while (!stack.empty()) {
+		CirGate* g = stack.back(); stack.pop_back();
+		if (!g->isInDFS()) continue;
+		g->setInDFS(false); _unlisted.push_back(g);
+		if (g->getType() != UNDEF_GATE) ++_dfsHoles;
+		if (g->getInput0() && g->getInput0()->isInDFS() && !g->getInput0()->hasDFSFanout())
+			stack.push_back(g->getInput0());
+		if (g->getInput1() && g->getInput1()->isInDFS() && !g->getInput1()->hasDFSFanout())
+			stack.push_back(g->getInput1());
+	}
 }
 
 /******************************************************/
@@ -14,6 +14,7 @@
 #include <fstream>
 #include <iostream>
 #include "sat.h"
+#include "cirSat.h"
 #include "cirDef.h"
 #include "cirGate.h"
 #include "myHashMap.h"
@@ -32,6 +33,7 @@ extern CirMgr *cirMgr;
 /*********************************/
 class SimKey;
 class StrashKey;
+class CirCut;
 
 /********************************/
 /*   CirMgr class declaration   */
@@ -46,7 +48,7 @@ public:
 	friend class CirPOGate;
 	friend class CirUndefGate;
 	friend class CirConstGate;
-   CirMgr(): _simLog(0), _aigNum(0), _fecGroSize(0), _randSim(1) {}
+   CirMgr(): _simLog(0), _simLogBin(0), _aigNum(0), _dfsHoles(0), _dfsBroken(0), _dfsStale(1), _fecGroSize(0), _fecProven(0), _simConeLive(0), _circuitSat(0), _raceNum(1), _raceBudget(0) {}
    ~CirMgr() {}
 
    // Access functions
@@ -56,19 +58,30 @@ public:
    // Member functions about circuit construction
    bool readCircuit(const string&);
 
+   // Member functions about circuit snapshot
+   void saveSnapshot(ostream&, unsigned);
+   bool loadSnapshot(const string&, unsigned&);
+
    // Member functions about circuit optimization
    void sweep();
    void optimize();
+   void rewrite();
+   void balance();
+   void resub();
 
    // Member functions about simulation
    void randomSim();
    void fileSim(ifstream&);
-   void setSimLog(ofstream*);
+   bool exhaustiveSim();
+   void targetedSim();
+   void setSimLog(ofstream*, bool = false);
 
    // Member functions about fraig
    void strash();
    void printFEC() const;
-   void fraig();
+   void fraig(bool = false);
+   bool setProof(const string&);
+   void setRace(int, int);
 
    // Member functions about circuit reporting
    void printSummary() const;
@@ -81,6 +94,8 @@ public:
    
    // Member functions about circuit searching
    void cirDFSearch();
+   void cirDFSUpdate();
+   void cirDFSFresh();
    
    // Member functions about gate merging
    void gateMerge(CirGate*, CirGate*, bool);
@@ -90,6 +105,7 @@ public:
 
 private:
    ofstream       *_simLog;
+   bool           _simLogBin;  // write packed words instead of 0/1 text
 	unsigned       _maxVar;
 	unsigned			_inNum;
 	unsigned			_outNum;
@@ -101,22 +117,56 @@ private:
 	size_t 			_aigNum;
 	GateList 		_totList;
 	GateList 		_dfsList;
+	size_t         _dfsHoles;   // merged or dangling gates still listed
+	bool           _dfsBroken;  // _dfsList is no longer topologically sorted
+	bool           _dfsStale;   // _dfsList may differ from a fresh DFS order
+	GateList       _unlisted;   // gates off _dfsList since the last search (for sweep)
 	FECGroups		_fecGroups;
 	size_t			_fecGroSize;
+	bool				_fecProven;   // FEC groups are exact (all patterns simulated)
+	GateList       _simCone;     // fanin cones of the FEC candidates, in DFS order
+	size_t         _simConeLive; // FEC candidates when _simCone was built (0: none yet)
 	SatSolver		_solver;
-	vector<size_t> _piValVec;
-	vector<size_t> _poValVec;
-	vector<string> _valPattern;
-	bool           _randSim;
+	CirSat			_csat;
+	bool				_circuitSat;  // fraig queries go to _csat instead of _solver
+	int				_raceNum;     // racing solvers for hard fraig queries (1: none)
+	int				_raceBudget;  // conflicts before a fraig query is raced
+	vector<unsigned> _rwRef;     // fanout pins of live gates while rewriting
+	vector<bool>   _rwStale;     // IDs freed or reused by the current rewrite
+	vector<unsigned> _balLevel;  // logic levels while balancing
+	vector<bool>   _balInner;    // ANDs inside a supergate while balancing
+	vector<size_t> _rsbSig;      // simulation signatures while resubstituting
+	// Private member functions about circuit searching
+	bool           dfsMerge(CirGate*, CirGate*);
+	void           dfsRemove(CirGate*);
 	// Private member functions about optimization
-	void           sweepClearOut(CirGate*, size_t);
 	void           optDelGate(CirGate*);
+	bool           optSimplify(CirGate*);
 	bool           optGateMerge(CirGate*, size_t, bool);
+	// Private member functions about rewriting
+	bool           rwLeaves(const CirCut&, CirGate**, bool*);
+	size_t         rwDeref(CirGate*, CirGate**, GateList&, size_t = (size_t)-1);
+	void           rwReref(const GateList&, CirGate**);
+	bool           rwIsLeaf(CirGate*, CirGate**) const;
+	size_t         rwBuild(const vector<unsigned>&, CirGate**, bool*, bool, const GateList&, bool, IdList* = 0, size_t* = 0);
+	void           rwReplace(CirGate*, const vector<unsigned>&, CirGate**, bool*, bool, const GateList&);
+	// Private member functions about balancing
+	void           balCollect(CirGate*, vector<size_t>&, GateList&);
+	size_t         balAnd(size_t, size_t, IdList&);
+	void           balRoot(CirGate*);
+	// Private member functions about resubstitution
+	void           rsbDivisors(const GateList&, GateList&, GateList&);
+	size_t         rsbRelease(const GateList&);
+	bool           rsbPair(CirGate*, const GateList&, const GateList&);
+	bool           rsbProve(Var, Var, bool);
+	void           rsbReplace(CirGate*, const GateList&, size_t, size_t);
 	// Private member functions about simulation
-	bool           fileCheck(ifstream&, vector<string>&);
+	bool           filePatCheck(const string&);
    void 				cirRandSim();
+   void           simConeUpdate(size_t);
+   size_t         simLiveCount() const;
    void 				cirFileSim();
-   void           filePISim(vector<string>&, size_t, size_t);
+   void           fileWordSim(vector<size_t>&, size_t, bool&);
    void           valPISim(vector<size_t>&, GateList&);
    bool 				fecCheck(GateList, bool);
    bool 				fecReCheck(bool, bool, bool);
@@ -128,15 +178,17 @@ private:
    void           randPrint();
    void           filePrint();
    void           fraigPrint(bool);
-   void           valRecordClear();
-   void           cycleWrite(vector<string>&, vector<size_t>, size_t, size_t);
-   void				randWriteValToStr();
-   void				fileWriteValToStr();
-   void				strTranpose(vector<string>&);
+   void           simLogWrite(size_t);
+   void           simLogWord(size_t);
    // Private member functions about fraig
    void           genProofModel();
+   void           genCircuitModel();
    void           solveFECPairs();
    void           solveDFSList(vector<size_t>&, size_t&, bool&);
+   void           solveFECGroup(CirGate*, size_t, size_t, const vector<size_t>&, vector<size_t>&, vector<SatPairResult>&, size_t);
+   SatPairStatus  solveExact(CirGate*, CirGate*, bool, vector<int>&);
+   bool           solveFEC(CirGate*, CirGate*, bool);
+   void           boostQueryVars(CirGate*, CirGate*);
    void           proveMessage(size_t, size_t, bool, bool);
 };
 
@@ -18,80 +18,68 @@ using namespace std;
 // TODO: Please keep "CirMgr::sweep()" and "CirMgr::optimize()" for cir cmd.
 //       Feel free to define your own variables or functions
 
+static bool gateIDLess(const CirGate* a, const CirGate* b)
+{
+	return a->getGateID() < b->getGateID();
+}
+
 /**************************************************/
 /*   Public member functions about optimization   */
 /**************************************************/
 void
 CirMgr::sweep()
 {
-	_dfsList.resize(0); cirDFSearch();
-	// Sweep floating gates
-	for (size_t i = 0; i < _totList.size(); ++i) {
-		if (_totList[i] && !_totList[i]->eqGlobalRef()) {
-			if (_totList[i]->getTypeStr() == "AIG") {
-				if (_totList[i]->getInput0()) sweepClearOut(_totList[i], 0);
-				if (_totList[i]->getInput1()) sweepClearOut(_totList[i], 1);
-				--_aigNum;
-				_totList[i] = 0;
-				cout << "Sweeping: AIG(" << i << ") removed..." << endl;
-			}
-			else if (_totList[i]->getTypeStr() == "UNDEF") {
-				_undefList.erase(remove(_undefList.begin(), _undefList.end(), _totList[i]), _undefList.end());
-				_totList[i] = 0;
-				cout << "Sweeping: UNDEF(" << i << ") removed..." << endl;
-			}
+	if (_dfsList.size() == 0) cirDFSearch();
+	// Only gates dropped from _dfsList can be floating; visit them by ID
+	sort(_unlisted.begin(), _unlisted.end(), gateIDLess);
+	_unlisted.erase(unique(_unlisted.begin(), _unlisted.end()), _unlisted.end());
+	for (size_t i = 0; i < _unlisted.size(); ++i) {
+		CirGate* gate = _unlisted[i];
+		size_t id = gate->getGateID();
+		if (_totList[id] != gate || gate->isInDFS()) continue;
+		if (gate->getTypeStr() == "AIG") {
+			if (gate->getInput0()) gate->getInput0()->removeOutput(gate);
+			if (gate->getInput1()) gate->getInput1()->removeOutput(gate);
+			--_aigNum;
+			_totList[id] = 0;
+			cout << "Sweeping: AIG(" << id << ") removed..." << endl;
+		}
+		else if (gate->getTypeStr() == "UNDEF") {
+			_undefList.erase(remove(_undefList.begin(), _undefList.end(), gate), _undefList.end());
+			_totList[id] = 0;
+			cout << "Sweeping: UNDEF(" << id << ") removed..." << endl;
 		}
 	}
+	_unlisted.resize(0);
 }
 
 void
 CirMgr::optimize()
 {
-	if (_dfsList.size() == 0) cirDFSearch();
-	bool resetDFSList = false;
-	for (size_t i = 0; i < _dfsList.size(); ++i) {
-		if (_dfsList[i]->getInput0() && _dfsList[i]->getTypeStr() != "PO") {
-			// Identical fanins
-			if (_dfsList[i]->getInput1() && _dfsList[i]->getInput0() == _dfsList[i]->getInput1()) {
-				// Identical phases
-				if (_dfsList[i]->getisInv0() == _dfsList[i]->getisInv1())
-					resetDFSList = optGateMerge(_dfsList[i], 0, false);
-				// Inverted phases
-				else resetDFSList = optGateMerge(_dfsList[i], 0, true);
-			}
-			// has constant 0
-			else if (_dfsList[i]->getInput0()->getGateID() == 0 && !_dfsList[i]->getisInv0())
-				resetDFSList = optGateMerge(_dfsList[i], 0, false);
-			else if (_dfsList[i]->getInput1() && _dfsList[i]->getInput1()->getGateID() == 0 && !_dfsList[i]->getisInv1())
-				resetDFSList = optGateMerge(_dfsList[i], 1, false);
-			// has constant 1
-			else if (_dfsList[i]->getInput0()->getGateID() == 0 && _dfsList[i]->getisInv0()) {
-				if (_dfsList[i]->getInput1()) resetDFSList = optGateMerge(_dfsList[i], 1, false);
-				else resetDFSList = optGateMerge(_dfsList[i], 0, false);
-			}
-			else if (_dfsList[i]->getInput1() && _dfsList[i]->getInput1()->getGateID() == 0 && _dfsList[i]->getisInv1())
-				resetDFSList = optGateMerge(_dfsList[i], 0, false);
-		}
+	cirDFSFresh();
+	// Every listed gate is tried once in topological order; a merge sends
+	// the fanouts it rewired back for another try, so one run reaches the
+	// fixed point and later work stays within the changed region
+	GateList work(_dfsList.rbegin(), _dfsList.rend());
+	CirGate::setGlobalRef();
+	while (!work.empty()) {
+		CirGate* gate = work.back(); work.pop_back();
+		if (!gate->isInDFS()) continue;
+		gate->setToGlobalRef();
+		GateList outList = gate->getOutput();
+		if (!optSimplify(gate)) continue;
+		// Fanouts not reached yet are tried in order anyway
+		for (size_t i = 0; i < outList.size(); ++i)
+			if (outList[i]->isInDFS() && outList[i]->eqGlobalRef())
+				work.push_back(outList[i]);
 	}
 	
-	if (resetDFSList) { _dfsList.resize(0); cirDFSearch(); }
+	cirDFSUpdate();
 }
 
 /***************************************************/
 /*   Private member functions about optimization   */
 /***************************************************/
-void
-CirMgr::sweepClearOut(CirGate* gate, size_t pin)
-{
-	GateList outputList; CirGate* inGate;
-	if (pin == 0) { outputList = gate->getInput0()->getOutput(); inGate = gate->getInput0(); }
-	else { outputList = gate->getInput1()->getOutput(); inGate = gate->getInput1();}
-	if (outputList.size() != 0)
-		for (size_t i = 0; i < outputList.size(); ++i)
-			if (!outputList[i]->eqGlobalRef())
-				inGate->removeOutput(outputList[i]);
-}
-
 void
 CirMgr::optDelGate(CirGate* gate)
 {
@@ -101,6 +89,35 @@ CirMgr::optDelGate(CirGate* gate)
 	}
 }
 
+// Apply the first rule that fits "gate"; return true if it was merged
+bool
+CirMgr::optSimplify(CirGate* gate)
+{
+	if (!gate->getInput0() || gate->getTypeStr() == "PO") return false;
+	// Identical fanins
+	if (gate->getInput1() && gate->getInput0() == gate->getInput1()) {
+		// Identical phases
+		if (gate->getisInv0() == gate->getisInv1())
+			optGateMerge(gate, 0, false);
+		// Inverted phases
+		else optGateMerge(gate, 0, true);
+	}
+	// has constant 0
+	else if (gate->getInput0()->getGateID() == 0 && !gate->getisInv0())
+		optGateMerge(gate, 0, false);
+	else if (gate->getInput1() && gate->getInput1()->getGateID() == 0 && !gate->getisInv1())
+		optGateMerge(gate, 1, false);
+	// has constant 1
+	else if (gate->getInput0()->getGateID() == 0 && gate->getisInv0()) {
+		if (gate->getInput1()) optGateMerge(gate, 1, false);
+		else optGateMerge(gate, 0, false);
+	}
+	else if (gate->getInput1() && gate->getInput1()->getGateID() == 0 && gate->getisInv1())
+		optGateMerge(gate, 0, false);
+	else return false;
+	return true;
+}
+
 bool
 CirMgr::optGateMerge(CirGate* gate, size_t pin, bool isConst0)
 {
@@ -111,7 +128,8 @@ CirMgr::optGateMerge(CirGate* gate, size_t pin, bool isConst0)
 		tmp = inv ? "!" : "";
 	}
 	else inGate = _totList[0];
-	gateMerge(inGate, gate, false); optDelGate(gate);
+	gateMerge(inGate, gate, false);
+	bool spliced = dfsMerge(inGate, gate); optDelGate(gate);
 	cout << "Simplifying: " << inGate->getGateID() << " merging " << tmp << gate->getGateID() << "..." << endl;
-	return true;
+	return spliced;
 }
\ No newline at end of file
@@ -0,0 +1,268 @@
+/****************************************************************************
+  FileName     [ cirResub.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define simulation-driven resubstitution ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2014 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <vector>
+#include <stdlib.h>
+#include "cirMgr.h"
+#include "cirGate.h"
+#include "sat.h"
+#include "util.h"
+
+using namespace std;
+
+// A gate is re-expressed by one divisor (d or !d) or by the AND of two
+// (with any input and output phases, i.e. also OR/NAND/NOR) when the
+// signatures match. Divisors are the gates of its fanin cone outside its
+// maximum fanout-free cone (MFFC), so they survive the replacement and
+// cannot form a loop. A match is kept only if SAT proves it and the gates
+// freed outnumber the gates used. Only a window of the MFFC next to the
+// gate is taken apart; the rest of it is freed once a match is kept.
+
+#define RSB_SIM_WORDS   8      // The CIRSIMulate word and 7 of our own
+#define RSB_WINDOW_LIMIT 50    // MFFC gates taken apart per gate
+#define RSB_DIV_LIMIT   150    // Divisors per gate
+#define RSB_PAIR_LIMIT  40     // Candidates of each phase for the AND pairs
+#define RSB_SAT_BUDGET  1000   // Conflicts per query
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static const size_t* rsbSig(const vector<size_t>& sig, CirGate* g) { return &sig[g->getGateID() * RSB_SIM_WORDS]; }
+
+static size_t rsbRand()
+{
+	return ((size_t)rand() << 33) ^ ((size_t)rand() << 11) ^ (size_t)rand();
+}
+
+// Phase "inv" of signature "a" equals "t"
+static bool rsbEqual(const size_t* t, const size_t* a, bool inv)
+{
+	size_t mask = inv ? ~(size_t)0 : 0;
+	for (size_t w = 0; w < RSB_SIM_WORDS; ++w)
+		if (t[w] != (a[w] ^ mask)) return false;
+	return true;
+}
+
+// Phase "inv" of signature "a" is 1 wherever "t" is
+static bool rsbCovers(const size_t* t, const size_t* a, bool inv)
+{
+	size_t mask = inv ? ~(size_t)0 : 0;
+	for (size_t w = 0; w < RSB_SIM_WORDS; ++w)
+		if (t[w] & ~(a[w] ^ mask)) return false;
+	return true;
+}
+
+/****************************************************/
+/*   Public member functions about resubstitution   */
+/****************************************************/
+void
+CirMgr::resub()
+{
+	if (_dfsList.size() == 0) cirDFSearch();
+	// Signatures: word 0 is what CIRSIMulate left in the gates
+	_rsbSig.assign(_totList.size() * RSB_SIM_WORDS, 0);
+	for (size_t i = 0; i < _dfsList.size(); ++i) {
+		CirGate* g = _dfsList[i];
+		if (!g->isInDFS()) continue;
+		size_t* s = &_rsbSig[g->getGateID() * RSB_SIM_WORDS];
+		s[0] = g->getGateValue();
+		for (size_t w = 1; w < RSB_SIM_WORDS; ++w) {
+			if (g->getType() == PI_GATE) s[w] = rsbRand();
+			else if (g->getType() == AIG_GATE) {
+				const size_t* a = rsbSig(_rsbSig, g->getInput0());
+				const size_t* b = rsbSig(_rsbSig, g->getInput1());
+				s[w] = (a[w] ^ (g->getisInv0() ? ~(size_t)0 : 0)) & (b[w] ^ (g->getisInv1() ? ~(size_t)0 : 0));
+			}
+		}
+	}
+	// The whole circuit as CNF; a proven match leaves it valid
+	_solver.initialize();
+	_solver.setRace(1, 0);
+	_totList[0]->setVar(_solver.newVar());
+	_solver.assertProperty(_totList[0]->getVar(), false);
+	for (size_t i = 0; i < _dfsList.size(); ++i)
+		if (_dfsList[i]->isInDFS() && _dfsList[i]->getType() != CONST_GATE) _dfsList[i]->setVar(_solver.newVar());
+	for (size_t i = 0; i < _dfsList.size(); ++i) {
+		CirGate* g = _dfsList[i];
+		if (!g->isInDFS() || g->getType() != AIG_GATE) continue;
+		_solver.addAigCNF(g->getVar(), g->getInput0()->getVar(), g->getisInv0(), g->getInput1()->getVar(), g->getisInv1());
+	}
+	// Fanout pins of the live gates, as in rewriting
+	_rwRef.assign(_totList.size(), 0);
+	for (size_t i = 0; i < _dfsList.size(); ++i) {
+		CirGate* g = _dfsList[i];
+		if (!g->isInDFS()) continue;
+		if (g->getInput0()) ++_rwRef[g->getInput0()->getGateID()];
+		if (g->getInput1()) ++_rwRef[g->getInput1()->getGateID()];
+	}
+	CirGate* noLeaves[4] = { 0, 0, 0, 0 };
+	GateList order = _dfsList;
+	for (size_t i = 0; i < order.size(); ++i) {
+		CirGate* gate = order[i];
+		unsigned id = gate->getGateID();
+		if (gate->getType() != AIG_GATE || !gate->isInDFS() || _totList[id] != gate || _rwRef[id] == 0) continue;
+		GateList mffc, bound, divs;
+		rwDeref(gate, noLeaves, mffc, RSB_WINDOW_LIMIT);
+		rsbDivisors(mffc, bound, divs);
+		const size_t* t = rsbSig(_rsbSig, gate);
+		bool done = false;
+		// One divisor: all of the MFFC goes
+		for (size_t j = 0; j < divs.size() && !done; ++j)
+			for (size_t p = 0; p < 2 && !done; ++p) {
+				if (!rsbEqual(t, rsbSig(_rsbSig, divs[j]), p)) continue;
+				if (!rsbProve(gate->getVar(), divs[j]->getVar(), p)) continue;
+				rsbReplace(gate, mffc, (size_t)divs[j] + p, 0);
+				done = true;
+			}
+		// Two divisors: the gate stays and takes them as fanins
+		if (!done && mffc.size() >= 2) done = rsbPair(gate, mffc, divs);
+		if (!done) { rwReref(mffc, noLeaves); continue; }
+		size_t saved = mffc.size() - (_totList[id] ? 1 : 0) + rsbRelease(bound);
+		cout << "Resubstituting: " << id << " saving " << saved << " gate" << (saved > 1 ? "s" : "") << "..." << endl;
+	}
+	_rwRef.clear(); _rsbSig.clear();
+	cirDFSearch();
+}
+
+/*****************************************************/
+/*   Private member functions about resubstitution   */
+/*****************************************************/
+// Gates of the fanin cone of the window "mffc" (rooted at its first gate)
+// outside it, nearest first; "bound" gets the fanins of the window
+void
+CirMgr::rsbDivisors(const GateList& mffc, GateList& bound, GateList& divs)
+{
+	CirGate::setGlobalRef();
+	for (size_t i = 0; i < mffc.size(); ++i) mffc[i]->setToGlobalRef();
+	for (size_t i = 0; i < mffc.size(); ++i) {
+		CirGate* in[2] = { mffc[i]->getInput0(), mffc[i]->getInput1() };
+		for (size_t k = 0; k < 2; ++k) {
+			if (!in[k] || in[k]->eqGlobalRef()) continue;
+			in[k]->setToGlobalRef();
+			bound.push_back(in[k]);
+		}
+	}
+	GateList queue;
+	for (size_t i = 0; i < bound.size() && divs.size() < RSB_DIV_LIMIT; ++i) {
+		if (bound[i]->getType() != AIG_GATE && bound[i]->getType() != PI_GATE) continue;
+		divs.push_back(bound[i]); queue.push_back(bound[i]);
+	}
+	for (size_t i = 0; i < queue.size() && divs.size() < RSB_DIV_LIMIT; ++i) {
+		CirGate* in[2] = { queue[i]->getInput0(), queue[i]->getInput1() };
+		for (size_t k = 0; k < 2; ++k) {
+			if (!in[k] || in[k]->eqGlobalRef()) continue;
+			in[k]->setToGlobalRef();
+			if (in[k]->getType() != AIG_GATE && in[k]->getType() != PI_GATE) continue;
+			divs.push_back(in[k]); queue.push_back(in[k]);
+		}
+	}
+}
+
+// Look for two divisors whose AND matches "gate" and use the first proven
+// pair; the AND must cover the target, so each divisor must
+bool
+CirMgr::rsbPair(CirGate* gate, const GateList& mffc, const GateList& divs)
+{
+	const size_t* sig = rsbSig(_rsbSig, gate);
+	for (size_t o = 0; o < 2; ++o) {
+		size_t t[RSB_SIM_WORDS];
+		for (size_t w = 0; w < RSB_SIM_WORDS; ++w) t[w] = o ? ~sig[w] : sig[w];
+		vector<size_t> cands;
+		for (size_t j = 0; j < divs.size() && cands.size() < 2 * RSB_PAIR_LIMIT; ++j)
+			for (size_t p = 0; p < 2; ++p)
+				if (rsbCovers(t, rsbSig(_rsbSig, divs[j]), p)) cands.push_back((size_t)divs[j] + p);
+		for (size_t a = 0; a < cands.size(); ++a)
+			for (size_t b = a + 1; b < cands.size(); ++b) {
+				CirGate* ga = (CirGate*)(cands[a] & ~(size_t)1); CirGate* gb = (CirGate*)(cands[b] & ~(size_t)1);
+				if (ga == gb) continue;
+				const size_t* sa = rsbSig(_rsbSig, ga); const size_t* sb = rsbSig(_rsbSig, gb);
+				size_t ma = (cands[a] & 1) ? ~(size_t)0 : 0, mb = (cands[b] & 1) ? ~(size_t)0 : 0;
+				size_t w = 0;
+				while (w < RSB_SIM_WORDS && ((sa[w] ^ ma) & (sb[w] ^ mb)) == t[w]) ++w;
+				if (w < RSB_SIM_WORDS) continue;
+				Var v = _solver.newVar();
+				_solver.addAigCNF(v, ga->getVar(), cands[a] & 1, gb->getVar(), cands[b] & 1);
+				if (!rsbProve(gate->getVar(), v, o)) continue;
+				gate->setVar(v);
+				rsbReplace(gate, mffc, cands[a], cands[b] + (o << 1));
+				// The gate may be a divisor of later ones
+				if (o) for (size_t w = 0; w < RSB_SIM_WORDS; ++w) _rsbSig[gate->getGateID() * RSB_SIM_WORDS + w] = t[w];
+				return true;
+			}
+	}
+	return false;
+}
+
+// Free the gates of "bound" that the kept match left without a fanout,
+// with the part of their cone only they used; return their number
+size_t
+CirMgr::rsbRelease(const GateList& bound)
+{
+	GateList stack;
+	for (size_t i = 0; i < bound.size(); ++i)
+		if (bound[i]->getType() == AIG_GATE && _totList[bound[i]->getGateID()] == bound[i] && _rwRef[bound[i]->getGateID()] == 0)
+			stack.push_back(bound[i]);
+	size_t freed = 0;
+	while (!stack.empty()) {
+		CirGate* g = stack.back(); stack.pop_back();
+		CirGate* in[2] = { g->getInput0(), g->getInput1() };
+		for (size_t k = 0; k < 2; ++k) {
+			in[k]->removeOutput(g);
+			if (in[k]->getType() == AIG_GATE && --_rwRef[in[k]->getGateID()] == 0) stack.push_back(in[k]);
+		}
+		g->setInput(0, false, 0, false);
+		_totList[g->getGateID()] = 0; --_aigNum; ++freed;
+	}
+	return freed;
+}
+
+// True if var "a" always equals var "b" (inverted if "inv")
+bool
+CirMgr::rsbProve(Var a, Var b, bool inv)
+{
+	vector<SatPair> pairs(1, SatPair(a, b, inv, 0));
+	vector<SatPairResult> results;
+	_solver.solveBatch(pairs, vector<Var>(), results, RSB_SAT_BUDGET);
+	return results[0].status == SAT_PAIR_EQUIV;
+}
+
+// Replace "gate" (with its released cone "mffc") by literal "lit0", or by
+// the AND of "lit0" and "lit1" when "lit1" is set; bit 1 of "lit1"
+// inverts that AND
+void
+CirMgr::rsbReplace(CirGate* gate, const GateList& mffc, size_t lit0, size_t lit1)
+{
+	for (size_t i = 1; i < mffc.size(); ++i) {
+		CirGate* g = mffc[i];
+		g->getInput0()->removeOutput(g); g->getInput1()->removeOutput(g);
+		g->setInput(0, false, 0, false);
+		_totList[g->getGateID()] = 0; --_aigNum;
+	}
+	gate->getInput0()->removeOutput(gate); gate->getInput1()->removeOutput(gate);
+	gate->setInput(0, false, 0, false);
+	CirGate* g0 = (CirGate*)(lit0 & ~(size_t)3);
+	if (!lit1) {
+		_rwRef[g0->getGateID()] += _rwRef[gate->getGateID()];
+		gateMerge(g0, gate, lit0 & 1);
+		_totList[gate->getGateID()] = 0; --_aigNum;
+		return;
+	}
+	CirGate* g1 = (CirGate*)(lit1 & ~(size_t)3);
+	gate->setInput(g0, lit0 & 1, g1, lit1 & 1);
+	g0->addOutput(gate); g1->addOutput(gate);
+	++_rwRef[g0->getGateID()]; ++_rwRef[g1->getGateID()];
+	// Keep the simulated value: it decides the phase of FEC pairs
+	gate->setGateValue();
+	if (!(lit1 & 2)) return;
+	GateList outList = gate->getOutput();
+	for (size_t i = 0; i < outList.size(); ++i) {
+		if (outList[i]->getInput0() == gate) outList[i]->setInv0(!outList[i]->getisInv0());
+		if (outList[i]->getInput1() == gate) outList[i]->setInv1(!outList[i]->getisInv1());
+	}
+}
@@ -0,0 +1,368 @@
+/****************************************************************************
+  FileName     [ cirRewrite.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cut-based AIG rewriting with NPN classes ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2014 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include "cirMgr.h"
+#include "cirGate.h"
+#include "cirCut.h"
+#include "myHashMap.h"
+#include "util.h"
+
+using namespace std;
+
+// Every 4-input truth table is mapped to the smallest member of its NPN
+// class and the transform that rebuilds it from that representative.
+// Each representative gets one AIG form, found by a search over AND trees
+// of increasing size (shared subfunctions are built once). Both tables
+// are generated at the first CIRREWrite.
+
+#define RWR_PERM_NUM   24
+#define RWR_COST_LIMIT 10     // Larger forms can hardly pay off in a 4-cut
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static const unsigned short rwrVarTruth[4] = { 0xAAAA, 0xCCCC, 0xF0F0, 0xFF00 };
+
+// A form is a list of AND nodes over literals 2 * index + inverted, where
+// index 0 is the constant 0, 1..4 the inputs, and 5.. the nodes in order;
+// the last entry is the root literal
+typedef vector<unsigned> RwrForm;
+
+class RwrLib
+{
+public:
+   RwrLib();
+
+   // f(x) = out ^ rep(y) with y_i = x_perm[i] ^ neg_i
+   unsigned short getRep(unsigned short f) const { return _rep[f]; }
+   const unsigned* getPerm(unsigned short f) const { return _perm[_trans[f] & 31]; }
+   bool getNeg(unsigned short f, unsigned i) const { return (_trans[f] >> (5 + i)) & 1; }
+   bool getOut(unsigned short f) const { return (_trans[f] >> 9) & 1; }
+   // Empty if the class has no form within RWR_COST_LIMIT
+   const RwrForm& getForm(unsigned short rep) const { return _forms[_classOf[rep]]; }
+
+private:
+   unsigned             _perm[RWR_PERM_NUM][4];
+   vector<unsigned short> _rep;
+   vector<unsigned short> _trans;     // perm | neg << 5 | out << 9
+   vector<unsigned>     _classOf;     // class number of a representative
+   vector<RwrForm>      _forms;
+
+   unsigned short transform(unsigned short, unsigned) const;
+   unsigned buildForm(unsigned short, const vector<unsigned>&, RwrForm&, vector<unsigned>&) const;
+};
+
+RwrLib::RwrLib(): _rep(65536), _trans(65536, 0xFFFF), _classOf(65536, 0)
+{
+   unsigned n = 0;
+   for (unsigned a = 0; a < 4; ++a)
+      for (unsigned b = 0; b < 4; ++b)
+         for (unsigned c = 0; c < 4; ++c)
+            for (unsigned d = 0; d < 4; ++d)
+               if (a != b && a != c && a != d && b != c && b != d && c != d) {
+                  _perm[n][0] = a; _perm[n][1] = b; _perm[n][2] = c; _perm[n][3] = d; ++n;
+               }
+   assert(n == RWR_PERM_NUM);
+   // Classes: the first unvisited table is the smallest of its class
+   vector<unsigned short> reps;
+   for (unsigned f = 0; f < 65536; ++f) {
+      if (_trans[f] != 0xFFFF) continue;
+      _classOf[f] = reps.size(); reps.push_back(f);
+      for (unsigned t = 0; t < 1024; ++t) {
+         if ((t & 31) >= RWR_PERM_NUM) continue;
+         unsigned short g = transform(f, t);
+         if (_trans[g] == 0xFFFF) { _rep[g] = f; _trans[g] = t; }
+      }
+   }
+   // Cheapest AND tree of every table, by increasing node count
+   // fanin[f]: the pair of tables whose AND is f (0 for f itself inverted)
+   vector<int> cost(65536, -1);
+   vector<unsigned> fanin(65536, 0);
+   vector<vector<unsigned short> > level(RWR_COST_LIMIT + 1);
+   cost[0] = cost[0xFFFF] = 0;
+   for (unsigned i = 0; i < 4; ++i) {
+      unsigned short v = rwrVarTruth[i];
+      cost[v] = cost[(unsigned short)~v] = 0;
+      level[0].push_back(v); level[0].push_back(~v);
+   }
+   for (int c = 1; c <= RWR_COST_LIMIT; ++c)
+      for (int a = 0; a <= (c - 1) / 2; ++a) {
+         const vector<unsigned short>& la = level[a];
+         const vector<unsigned short>& lb = level[c - 1 - a];
+         for (size_t i = 0; i < la.size(); ++i)
+            for (size_t j = (&la == &lb ? i + 1 : 0); j < lb.size(); ++j) {
+               unsigned short f = la[i] & lb[j];
+               if (cost[f] != -1) continue;
+               cost[f] = cost[(unsigned short)~f] = c;
+               fanin[f] = ((unsigned)la[i] << 16) | lb[j];
+               level[c].push_back(f); level[c].push_back(~f);
+            }
+      }
+   _forms.resize(reps.size());
+   for (size_t i = 0; i < reps.size(); ++i) {
+      if (cost[reps[i]] == -1) continue;
+      vector<unsigned> memo(65536, 0);
+      unsigned root = buildForm(reps[i], fanin, _forms[i], memo);
+      _forms[i].push_back(root);
+   }
+}
+
+unsigned short
+RwrLib::transform(unsigned short f, unsigned t) const
+{
+   const unsigned* perm = _perm[t & 31];
+   unsigned short g = 0;
+   for (unsigned x = 0; x < 16; ++x) {
+      unsigned y = 0;
+      for (unsigned i = 0; i < 4; ++i)
+         y |= (((x >> perm[i]) ^ (t >> (5 + i))) & 1) << i;
+      g |= (((f >> y) ^ (t >> 9)) & 1) << x;
+   }
+   return g;
+}
+
+// Return the literal of "f" in "form", adding the nodes it needs
+unsigned
+RwrLib::buildForm(unsigned short f, const vector<unsigned>& fanin, RwrForm& form, vector<unsigned>& memo) const
+{
+   if (f == 0) return 0;
+   if (f == 0xFFFF) return 1;
+   for (unsigned i = 0; i < 4; ++i) {
+      if (f == rwrVarTruth[i]) return 2 * (i + 1);
+      if (f == (unsigned short)~rwrVarTruth[i]) return 2 * (i + 1) + 1;
+   }
+   if (memo[f]) return memo[f];
+   if (fanin[f] == 0) return (memo[f] = buildForm(~f, fanin, form, memo) ^ 1);
+   unsigned a = buildForm(fanin[f] >> 16, fanin, form, memo);
+   unsigned b = buildForm(fanin[f] & 0xFFFF, fanin, form, memo);
+   form.push_back(a); form.push_back(b);
+   return (memo[f] = 2 * (4 + form.size() / 2));
+}
+
+static const RwrLib& rwrLib()
+{
+   static RwrLib lib;
+   return lib;
+}
+
+/************************************/
+/*   HashKey class implementation   */
+/************************************/
+class RwrKey
+{
+public:
+	RwrKey(): _in0(0), _in1(0) {}
+	RwrKey(CirGate* g0, bool inv0, CirGate* g1, bool inv1) {
+		_in0 = (size_t)g0 + (size_t)inv0; _in1 = (size_t)g1 + (size_t)inv1;
+		if (_in0 > _in1) { size_t t = _in0; _in0 = _in1; _in1 = t; }
+	}
+	~RwrKey() {}
+	bool operator == (const RwrKey& k) const { return _in0 == k._in0 && _in1 == k._in1; }
+	size_t operator() () const { return _in0 + _in1 + (_in0 % 256) * (_in1 % 256); }
+
+private:
+	size_t   _in0;
+	size_t   _in1;
+};
+
+static HashMap<RwrKey, CirGate*>* rwrHash = 0;
+
+/**********************************************/
+/*   Public member functions about rewriting   */
+/**********************************************/
+void
+CirMgr::rewrite()
+{
+	if (_dfsList.size() == 0) cirDFSearch();
+	const RwrLib& lib = rwrLib();
+	CirCutMgr cuts;
+	cuts.compute(_dfsList, _totList.size(), 4, 8);
+	// Fanout pins of the live gates, and the strash table of their ANDs
+	_rwRef.assign(_totList.size(), 0);
+	_rwStale.assign(_totList.size(), false);
+	rwrHash = new HashMap<RwrKey, CirGate*>(getHashSize(_dfsList.size()));
+	for (size_t i = 0; i < _dfsList.size(); ++i) {
+		CirGate* g = _dfsList[i];
+		if (!g->isInDFS()) continue;
+		if (g->getInput0()) ++_rwRef[g->getInput0()->getGateID()];
+		if (g->getInput1()) ++_rwRef[g->getInput1()->getGateID()];
+		if (g->getType() == AIG_GATE)
+			rwrHash->replaceInsert(RwrKey(g->getInput0(), g->getisInv0(), g->getInput1(), g->getisInv1()), g);
+	}
+	GateList order = _dfsList;
+	for (size_t i = 0; i < order.size(); ++i) {
+		CirGate* gate = order[i];
+		unsigned id = gate->getGateID();
+		if (gate->getType() != AIG_GATE || _totList[id] != gate || _rwRef[id] == 0) continue;
+		// Best cut: most gates saved
+		int bestGain = 0; unsigned bestCut = 0;
+		for (unsigned c = 1; c < cuts.cutNum(id); ++c) {
+			CirGate* leaves[4]; bool inv[4];
+			if (!rwLeaves(cuts.getCut(id, c), leaves, inv)) continue;
+			const RwrForm& form = lib.getForm(lib.getRep(cuts.getCut(id, c).getTruth() & 0xFFFF));
+			if (form.empty()) continue;
+			GateList mffc;
+			int gain = (int)rwDeref(gate, leaves, mffc);
+			gain -= (int)rwBuild(form, leaves, inv, lib.getOut(cuts.getCut(id, c).getTruth() & 0xFFFF), mffc, false, 0);
+			rwReref(mffc, leaves);
+			if (gain > bestGain) { bestGain = gain; bestCut = c; }
+		}
+		if (bestGain == 0) continue;
+		const CirCut& cut = cuts.getCut(id, bestCut);
+		CirGate* leaves[4]; bool inv[4];
+		rwLeaves(cut, leaves, inv);
+		unsigned short f = cut.getTruth() & 0xFFFF;
+		GateList mffc;
+		rwDeref(gate, leaves, mffc);
+		rwReplace(gate, lib.getForm(lib.getRep(f)), leaves, inv, lib.getOut(f), mffc);
+		cout << "Rewriting: " << id << " saving " << bestGain << " gate" << (bestGain > 1 ? "s" : "") << "..." << endl;
+	}
+	delete rwrHash; rwrHash = 0;
+	_rwRef.clear(); _rwStale.clear();
+	cirDFSearch();
+}
+
+/***********************************************/
+/*   Private member functions about rewriting   */
+/***********************************************/
+// Order the cut leaves as the inputs of its NPN representative; false if
+// a leaf was removed by an earlier rewrite
+bool
+CirMgr::rwLeaves(const CirCut& cut, CirGate** leaves, bool* inv)
+{
+	for (unsigned i = 0; i < cut.size(); ++i)
+		if (_rwStale[cut[i]] || !_totList[cut[i]]) return false;
+	const RwrLib& lib = rwrLib();
+	unsigned short f = cut.getTruth() & 0xFFFF;
+	const unsigned* perm = lib.getPerm(f);
+	// Inputs beyond the cut are don't-cares of the table
+	for (unsigned i = 0; i < 4; ++i) {
+		leaves[i] = (perm[i] < cut.size() ? _totList[cut[perm[i]]] : _totList[0]);
+		inv[i] = lib.getNeg(f, i);
+	}
+	return true;
+}
+
+// Release "gate" and the gates below it down to "leaves" that no other
+// gate uses, at most "limit" of them (a gate beyond it stays released but
+// is not entered); return their number
+size_t
+CirMgr::rwDeref(CirGate* gate, CirGate** leaves, GateList& mffc, size_t limit)
+{
+	// Depth first, fanin 0 first: (gate, next fanin) pairs
+	vector<pair<CirGate*, size_t> > stack(1, make_pair(gate, (size_t)0));
+	mffc.push_back(gate);
+	while (!stack.empty()) {
+		CirGate* g = stack.back().first;
+		size_t k = stack.back().second++;
+		if (k == 2) { stack.pop_back(); continue; }
+		CirGate* in = k ? g->getInput1() : g->getInput0();
+		if (in->getType() != AIG_GATE || rwIsLeaf(in, leaves)) continue;
+		if (--_rwRef[in->getGateID()] == 0 && mffc.size() < limit) {
+			mffc.push_back(in);
+			stack.push_back(make_pair(in, (size_t)0));
+		}
+	}
+	return mffc.size();
+}
+
+void
+CirMgr::rwReref(const GateList& mffc, CirGate** leaves)
+{
+	for (size_t i = 0; i < mffc.size(); ++i) {
+		CirGate* in[2] = { mffc[i]->getInput0(), mffc[i]->getInput1() };
+		for (size_t k = 0; k < 2; ++k)
+			if (in[k]->getType() == AIG_GATE && !rwIsLeaf(in[k], leaves))
+				++_rwRef[in[k]->getGateID()];
+	}
+}
+
+bool
+CirMgr::rwIsLeaf(CirGate* gate, CirGate** leaves) const
+{
+	for (size_t i = 0; i < 4; ++i)
+		if (leaves[i] == gate) return true;
+	return false;
+}
+
+// Instantiate "form" over the leaves, reusing live gates not in "mffc";
+// return the number of gates it adds. With "build", the gates are made
+// with IDs taken from "freeIDs" and the root is returned in "root"
+// (inverted if its lowest bit is set)
+size_t
+CirMgr::rwBuild(const RwrForm& form, CirGate** leaves, bool* inv, bool outInv, const GateList& mffc, bool build, IdList* freeIDs, size_t* root)
+{
+	// Literal values: gate pointer + inverted; 0 stands for a gate not made yet
+	vector<size_t> val(5 + form.size() / 2, 0);
+	val[0] = (size_t)_totList[0];
+	for (size_t i = 0; i < 4; ++i) val[i + 1] = (size_t)leaves[i] + inv[i];
+	size_t added = 0;
+	for (size_t k = 0; k + 1 < form.size(); k += 2) {
+		size_t a = val[form[k] >> 1], b = val[form[k + 1] >> 1];
+		size_t& out = val[5 + k / 2];
+		if (!a || !b) { ++added; out = 0; continue; }
+		a ^= form[k] & 1; b ^= form[k + 1] & 1;
+		CirGate* ga = (CirGate*)(a & ~(size_t)1); CirGate* gb = (CirGate*)(b & ~(size_t)1);
+		// Constants and trivial pairs need no gate
+		if ((ga == _totList[0] && !(a & 1)) || (gb == _totList[0] && !(b & 1)) || (ga == gb && a != b))
+			{ out = (size_t)_totList[0]; continue; }
+		if (ga == _totList[0]) { out = b; continue; }
+		if (gb == _totList[0] || a == b) { out = a; continue; }
+		CirGate* found = 0;
+		if (rwrHash->check(RwrKey(ga, a & 1, gb, b & 1), found) && _totList[found->getGateID()] == found
+			&& find(mffc.begin(), mffc.end(), found) == mffc.end()) { out = (size_t)found; continue; }
+		++added;
+		if (!build) { out = 0; continue; }
+		assert(!freeIDs->empty());
+		CirGate* g = new CirAIGGate;
+		g->setGateID(freeIDs->back()); freeIDs->pop_back();
+		g->setInput(ga, a & 1, gb, b & 1);
+		ga->addOutput(g); gb->addOutput(g);
+		++_rwRef[ga->getGateID()]; ++_rwRef[gb->getGateID()];
+		_totList[g->getGateID()] = g; ++_aigNum;
+		rwrHash->replaceInsert(RwrKey(ga, a & 1, gb, b & 1), g);
+		out = (size_t)g;
+	}
+	if (build) {
+		unsigned r = form.back();
+		*root = val[r >> 1] ^ (r & 1) ^ (size_t)outInv;
+	}
+	return added;
+}
+
+// Replace "gate" (with its released cone "mffc") by "form" over the leaves
+void
+CirMgr::rwReplace(CirGate* gate, const RwrForm& form, CirGate** leaves, bool* inv, bool outInv, const GateList& mffc)
+{
+	// Free the cone below the gate; its IDs go to the new gates
+	IdList freeIDs;
+	for (size_t i = 1; i < mffc.size(); ++i) {
+		CirGate* g = mffc[i];
+		g->getInput0()->removeOutput(g); g->getInput1()->removeOutput(g);
+		if (rwIsLeaf(g->getInput0(), leaves) || g->getInput0()->getType() != AIG_GATE) --_rwRef[g->getInput0()->getGateID()];
+		if (rwIsLeaf(g->getInput1(), leaves) || g->getInput1()->getType() != AIG_GATE) --_rwRef[g->getInput1()->getGateID()];
+		_totList[g->getGateID()] = 0; _rwStale[g->getGateID()] = true; --_aigNum;
+		freeIDs.push_back(g->getGateID());
+	}
+	CirGate* in[2] = { gate->getInput0(), gate->getInput1() };
+	size_t root = 0;
+	rwBuild(form, leaves, inv, outInv, mffc, true, &freeIDs, &root);
+	// Move the fanouts of the gate to the new root
+	CirGate* rootGate = (CirGate*)(root & ~(size_t)1);
+	for (size_t k = 0; k < 2; ++k) {
+		in[k]->removeOutput(gate);
+		if (rwIsLeaf(in[k], leaves) || in[k]->getType() != AIG_GATE) --_rwRef[in[k]->getGateID()];
+	}
+	gate->setInput(0, false, 0, false);
+	_rwRef[rootGate->getGateID()] += _rwRef[gate->getGateID()];
+	gateMerge(rootGate, gate, root & 1);
+	_totList[gate->getGateID()] = 0; _rwStale[gate->getGateID()] = true; --_aigNum;
+}
@@ -0,0 +1,443 @@
+/****************************************************************************
+  FileName     [ cirSat.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define circuit-based SAT solver for fraig queries ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2014 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <iostream>
+#include <algorithm>
+#include "cirSat.h"
+
+using namespace std;
+
+/*******************************/
+/*   Global variable and enum  */
+/*******************************/
+// Reasons of gate implications ("case" in _reason)
+enum CSatImply
+{
+   CSAT_FANIN0_ZERO = 0,   // output 0 from fanin0 at 0
+   CSAT_FANIN1_ZERO = 1,   // output 0 from fanin1 at 0
+   CSAT_TO_FANIN    = 2,   // a fanin from the output (and the other fanin)
+   CSAT_BOTH_ONE    = 3    // output 1 from both fanins at 1
+};
+
+#define CSAT_VAR_DECAY     0.95
+#define CSAT_CLA_DECAY     0.999
+#define CSAT_RESTART_FIRST 100
+#define CSAT_LEARNT_MIN    1000
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static inline unsigned gateReason(unsigned g, CSatImply c) { return (g << 3) | ((unsigned)c << 1); }
+static inline unsigned clauseReason(unsigned ci) { return (ci << 1) | 1; }
+
+class ClauseActLess
+{
+public:
+   ClauseActLess(const vector<float>& act): _act(act) {}
+   bool operator () (unsigned a, unsigned b) const { return _act[a] < _act[b]; }
+private:
+   const vector<float>& _act;
+};
+
+/***************************************/
+/*   class CirSat member functions      */
+/***************************************/
+void
+CirSat::reset()
+{
+   _fanin0.clear(); _fanin1.clear(); _fanout.clear();
+   _val.clear(); _level.clear(); _reason.clear();
+   _trail.clear(); _trailLim.clear(); _qhead = 0; _jFront.clear();
+   _clauses.clear(); _watches.clear(); _learntNum = 0; _claInc = 1;
+   _activity.clear(); _varInc = 1; _phase.clear();
+   _seen.clear(); _model.clear(); _confl.clear();
+   _ok = true;
+}
+
+unsigned
+CirSat::newNode()
+{
+   unsigned n = _val.size();
+   _fanin0.push_back(CSAT_NO_LIT); _fanin1.push_back(CSAT_NO_LIT);
+   _fanout.push_back(vector<unsigned>());
+   _val.push_back(2); _level.push_back(0); _reason.push_back(CSAT_NO_REASON);
+   _watches.push_back(vector<unsigned>()); _watches.push_back(vector<unsigned>());
+   _activity.push_back(0); _phase.push_back(0);
+   _seen.push_back(0); _model.push_back(0);
+   return n;
+}
+
+void
+CirSat::addAnd(unsigned f, unsigned a, bool fa, unsigned b, bool fb)
+{
+   assert(decisionLevel() == 0 && !isAnd(f) && a < f && b < f);
+   _fanin0[f] = a * 2 + fa; _fanin1[f] = b * 2 + fb;
+   _fanout[a].push_back(f);
+   if (b != a) _fanout[b].push_back(f);
+   if (_ok && (!propagateAnd(f) || !propagate())) _ok = false;
+}
+
+void
+CirSat::assertNode(unsigned n, bool val)
+{
+   assert(decisionLevel() == 0);
+   vector<unsigned> unit(1, n * 2 + !val);
+   addTopClause(unit);
+}
+
+bool
+CirSat::solve(const vector<unsigned>& assumps)
+{
+   if (!_ok) return false;
+   cancelUntil(0);
+   if (_learntNum >= CSAT_LEARNT_MIN + _val.size() / 3 + _trail.size()) reduceDB();
+
+   vector<unsigned> learnt;
+   size_t restartLim = CSAT_RESTART_FIRST, conflictNum = 0;
+   while (true) {
+      if (!propagate()) {
+         ++_conflicts; ++conflictNum;
+         if (decisionLevel() == 0) { _ok = false; return false; }
+         int btLevel = 0;
+         analyze(learnt, btLevel);
+         cancelUntil(btLevel);
+         if (learnt.size() == 1) assign(learnt[0], CSAT_NO_REASON);
+         else assign(learnt[0], clauseReason(addClause(learnt, true)));
+         _varInc /= CSAT_VAR_DECAY; _claInc /= CSAT_CLA_DECAY;
+         continue;
+      }
+      if (conflictNum >= restartLim) {
+         conflictNum = 0; restartLim += restartLim / 2;
+         cancelUntil(0);
+         continue;
+      }
+      unsigned d = CSAT_NO_LIT;
+      // Assumptions are the first decisions
+      while (decisionLevel() < (int)assumps.size()) {
+         unsigned p = assumps[decisionLevel()];
+         int v = litValue(p);
+         if (v == 0) {
+            vector<unsigned> cls(assumps.size());
+            for (size_t i = 0; i < assumps.size(); ++i) cls[i] = assumps[i] ^ 1;
+            cancelUntil(0);
+            addTopClause(cls);
+            return false;
+         }
+         _trailLim.push_back(_trail.size());
+         if (v == 2) { d = p; break; }
+      }
+      if (d == CSAT_NO_LIT) {
+         d = pickJustify();
+         if (d == CSAT_NO_LIT) {
+            // Every node at 0 has a fanin at 0: any input values extend it
+            saveModel();
+            cancelUntil(0);
+            return true;
+         }
+         _trailLim.push_back(_trail.size());
+      }
+      ++_decisions;
+      assign(d, CSAT_NO_REASON);
+   }
+}
+
+void
+CirSat::printStats() const
+{
+   cout << "CirSat: " << _decisions << " decisions, " << _conflicts << " conflicts, "
+        << _propagations << " propagations, " << _learntNum << " learnt clauses" << endl;
+}
+
+/************************************************/
+/*   Private member functions of class CirSat   */
+/************************************************/
+void
+CirSat::assign(unsigned p, unsigned reason)
+{
+   unsigned n = p >> 1;
+   assert(_val[n] == 2);
+   _val[n] = !(p & 1); _level[n] = decisionLevel(); _reason[n] = reason;
+   _trail.push_back(p);
+   if (_val[n] == 0 && isAnd(n)) _jFront.push_back(n);
+}
+
+void
+CirSat::cancelUntil(int level)
+{
+   if (decisionLevel() <= level) return;
+   for (size_t i = _trail.size(); i-- > _trailLim[level]; ) {
+      unsigned n = _trail[i] >> 1;
+      _val[n] = 2; _reason[n] = CSAT_NO_REASON;
+   }
+   _trail.resize(_trailLim[level]); _trailLim.resize(level);
+   _qhead = _trail.size();
+   // Drop the frontier entries that were unassigned
+   if (_jFront.size() > _trail.size()) {
+      size_t j = 0;
+      for (size_t i = 0; i < _jFront.size(); ++i)
+         if (_val[_jFront[i]] == 0) _jFront[j++] = _jFront[i];
+      _jFront.resize(j);
+   }
+}
+
+// Return false and leave the falsified clause in _confl on a conflict
+bool
+CirSat::propagate()
+{
+   while (_qhead < _trail.size()) {
+      unsigned p = _trail[_qhead++], n = p >> 1;
+      ++_propagations;
+      if (isAnd(n) && !propagateAnd(n)) return false;
+      for (size_t i = 0, m = _fanout[n].size(); i < m; ++i)
+         if (!propagateAnd(_fanout[n][i])) return false;
+      if (!propagateClauses(p)) return false;
+   }
+   return true;
+}
+
+bool
+CirSat::propagateAnd(unsigned g)
+{
+   unsigned a = _fanin0[g], b = _fanin1[g];
+   int va = litValue(a), vb = litValue(b), vg = _val[g];
+   if (va == 0 || vb == 0) {
+      if (vg == 2) assign(g * 2 + 1, gateReason(g, va == 0 ? CSAT_FANIN0_ZERO : CSAT_FANIN1_ZERO));
+      else if (vg == 1) {
+         _confl.resize(2); _confl[0] = g * 2 + 1; _confl[1] = (va == 0 ? a : b);
+         return false;
+      }
+   }
+   else if (va == 1 && vb == 1) {
+      if (vg == 2) assign(g * 2, gateReason(g, CSAT_BOTH_ONE));
+      else if (vg == 0) {
+         _confl.resize(3); _confl[0] = g * 2; _confl[1] = a ^ 1; _confl[2] = b ^ 1;
+         return false;
+      }
+   }
+   else if (vg == 1) {
+      if (va == 2) assign(a, gateReason(g, CSAT_TO_FANIN));
+      if (litValue(b) == 2) assign(b, gateReason(g, CSAT_TO_FANIN));
+   }
+   else if (vg == 0) {
+      if (va == 1) assign(b ^ 1, gateReason(g, CSAT_TO_FANIN));
+      else if (vb == 1) assign(a ^ 1, gateReason(g, CSAT_TO_FANIN));
+   }
+   return true;
+}
+
+bool
+CirSat::propagateClauses(unsigned p)
+{
+   unsigned falseLit = p ^ 1;
+   vector<unsigned>& ws = _watches[p];
+   size_t i = 0, j = 0;
+   while (i < ws.size()) {
+      unsigned ci = ws[i++];
+      vector<unsigned>& c = _clauses[ci].lits;
+      if (c[0] == falseLit) { c[0] = c[1]; c[1] = falseLit; }
+      ws[j++] = ci;
+      if (litValue(c[0]) == 1) continue;
+      // Look for a new literal to watch
+      bool moved = false;
+      for (size_t k = 2; k < c.size(); ++k)
+         if (litValue(c[k]) != 0) {
+            c[1] = c[k]; c[k] = falseLit;
+            _watches[c[1] ^ 1].push_back(ci);
+            --j; moved = true;
+            break;
+         }
+      if (moved) continue;
+      if (litValue(c[0]) == 0) {
+         _confl = c;
+         while (i < ws.size()) ws[j++] = ws[i++];
+         ws.resize(j);
+         return false;
+      }
+      assign(c[0], clauseReason(ci));
+   }
+   ws.resize(j);
+   return true;
+}
+
+// The other (false) literals of the clause that implied node "n"
+void
+CirSat::explain(unsigned n, vector<unsigned>& lits)
+{
+   unsigned r = _reason[n];
+   assert(r != CSAT_NO_REASON);
+   if (r & 1) {
+      CirSatClause& c = _clauses[r >> 1];
+      if (c.learnt) c.act += _claInc;
+      lits.assign(c.lits.begin() + 1, c.lits.end());
+      return;
+   }
+   unsigned g = r >> 3;
+   switch ((r >> 1) & 3) {
+      case CSAT_FANIN0_ZERO: lits.assign(1, _fanin0[g]); break;
+      case CSAT_FANIN1_ZERO: lits.assign(1, _fanin1[g]); break;
+      case CSAT_BOTH_ONE:
+         lits.resize(2); lits[0] = _fanin0[g] ^ 1; lits[1] = _fanin1[g] ^ 1;
+         break;
+      default:
+         if (_val[g] == 1) lits.assign(1, g * 2 + 1);
+         else {
+            unsigned other = (_fanin0[g] >> 1 == n ? _fanin1[g] : _fanin0[g]);
+            lits.resize(2); lits[0] = g * 2; lits[1] = other ^ 1;
+         }
+   }
+}
+
+// First-UIP conflict clause of _confl; its asserting literal comes first
+void
+CirSat::analyze(vector<unsigned>& learnt, int& btLevel)
+{
+   vector<unsigned> lits(_confl);
+   learnt.assign(1, 0);
+   int pathNum = 0;
+   unsigned p = CSAT_NO_LIT;
+   size_t idx = _trail.size();
+   while (true) {
+      for (size_t i = 0; i < lits.size(); ++i) {
+         unsigned n = lits[i] >> 1;
+         if (_seen[n] || _level[n] == 0) continue;
+         _seen[n] = 1; bumpNode(n);
+         if (_level[n] == decisionLevel()) ++pathNum;
+         else learnt.push_back(lits[i]);
+      }
+      do { p = _trail[--idx]; } while (!_seen[p >> 1]);
+      _seen[p >> 1] = 0;
+      if (--pathNum == 0) break;
+      explain(p >> 1, lits);
+   }
+   learnt[0] = p ^ 1;
+
+   btLevel = 0;
+   for (size_t i = 1; i < learnt.size(); ++i) {
+      _seen[learnt[i] >> 1] = 0;
+      if (_level[learnt[i] >> 1] > btLevel) {
+         btLevel = _level[learnt[i] >> 1];
+         swap(learnt[1], learnt[i]);
+      }
+   }
+}
+
+// Watch the first two literals; the second must be the last one to be falsified
+unsigned
+CirSat::addClause(const vector<unsigned>& lits, bool learnt)
+{
+   assert(lits.size() >= 2);
+   unsigned ci = _clauses.size();
+   _clauses.push_back(CirSatClause(lits, learnt));
+   _watches[lits[0] ^ 1].push_back(ci);
+   _watches[lits[1] ^ 1].push_back(ci);
+   if (learnt) { _clauses.back().act = _claInc; ++_learntNum; }
+   return ci;
+}
+
+void
+CirSat::addTopClause(vector<unsigned>& lits)
+{
+   assert(decisionLevel() == 0);
+   if (!_ok) return;
+   size_t j = 0;
+   for (size_t i = 0; i < lits.size(); ++i) {
+      int v = litValue(lits[i]);
+      if (v == 1) return;
+      if (v == 2) lits[j++] = lits[i];
+   }
+   lits.resize(j);
+   if (lits.empty()) _ok = false;
+   else if (lits.size() == 1) {
+      assign(lits[0], CSAT_NO_REASON);
+      if (!propagate()) _ok = false;
+   }
+   else addClause(lits, false);
+}
+
+// Return the literal that justifies the latest unjustified node, or
+// CSAT_NO_LIT if there is none
+unsigned
+CirSat::pickJustify()
+{
+   for (size_t i = _jFront.size(); i-- > 0; ) {
+      unsigned g = _jFront[i];
+      unsigned a = _fanin0[g], b = _fanin1[g];
+      int va = litValue(a), vb = litValue(b);
+      if (va == 0 || vb == 0) {
+         // Justified for as long as "g" keeps its value
+         if (_level[(va == 0 ? a : b) >> 1] <= _level[g]) {
+            _jFront[i] = _jFront.back(); _jFront.pop_back();
+         }
+         continue;
+      }
+      if (_val[g] != 0) continue;
+      assert(va == 2 && vb == 2);
+      // Prefer the fanin that is 0 in the simulated pattern, then the busier one
+      bool za = (_phase[a >> 1] ^ (a & 1)) == 0, zb = (_phase[b >> 1] ^ (b & 1)) == 0;
+      if (za != zb) return (za ? a : b) ^ 1;
+      return (_activity[a >> 1] >= _activity[b >> 1] ? a : b) ^ 1;
+   }
+   return CSAT_NO_LIT;
+}
+
+void
+CirSat::bumpNode(unsigned n)
+{
+   if ((_activity[n] += _varInc) > 1e100) {
+      for (size_t i = 0; i < _activity.size(); ++i) _activity[i] *= 1e-100;
+      _varInc *= 1e-100;
+   }
+}
+
+// Drop the less active half of the conflict clauses (at level 0 only,
+// where no reason is ever looked at again)
+void
+CirSat::reduceDB()
+{
+   assert(decisionLevel() == 0);
+   vector<unsigned> learnts;
+   vector<float> act(_clauses.size());
+   for (size_t i = 0; i < _clauses.size(); ++i) {
+      act[i] = _clauses[i].act;
+      if (_clauses[i].learnt) learnts.push_back(i);
+   }
+   sort(learnts.begin(), learnts.end(), ClauseActLess(act));
+   vector<char> drop(_clauses.size(), 0);
+   for (size_t i = 0; i < learnts.size() / 2; ++i) drop[learnts[i]] = 1;
+
+   size_t j = 0;
+   for (size_t i = 0; i < _clauses.size(); ++i) {
+      if (drop[i]) { --_learntNum; continue; }
+      if (i != j) _clauses[j] = _clauses[i];
+      _clauses[j].act = 0;
+      ++j;
+   }
+   _clauses.erase(_clauses.begin() + j, _clauses.end());
+   _claInc = 1;
+   for (size_t i = 0; i < _watches.size(); ++i) _watches[i].clear();
+   for (size_t i = 0; i < _clauses.size(); ++i) {
+      _watches[_clauses[i].lits[0] ^ 1].push_back(i);
+      _watches[_clauses[i].lits[1] ^ 1].push_back(i);
+   }
+   for (size_t i = 0; i < _trail.size(); ++i) _reason[_trail[i] >> 1] = CSAT_NO_REASON;
+}
+
+// Free inputs keep their value or take the phase; AND nodes are simulated
+void
+CirSat::saveModel()
+{
+   for (size_t n = 0; n < _val.size(); ++n) {
+      if (!isAnd(n)) _model[n] = (_val[n] == 2 ? _phase[n] : _val[n]);
+      else {
+         unsigned a = _fanin0[n], b = _fanin1[n];
+         _model[n] = (_model[a >> 1] ^ (a & 1)) & (_model[b >> 1] ^ (b & 1));
+      }
+      assert(_val[n] == 2 || _model[n] == _val[n]);
+   }
+}
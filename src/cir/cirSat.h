@@ -0,0 +1,112 @@
+/****************************************************************************
+  FileName     [ cirSat.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define circuit-based SAT solver for fraig queries ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2014 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_SAT_H
+#define CIR_SAT_H
+
+#include <vector>
+#include <climits>
+
+using namespace std;
+
+// A node is an AND gate (two fanin literals) or a free input; a literal is
+// node * 2 + inverted, as in AIGER. Propagation evaluates the AND nodes
+// directly, so the netlist is never lowered into clauses; only conflict
+// clauses are stored. Decisions justify the J-frontier -- AND nodes at 0
+// with no fanin at 0 yet -- so cones that need no value are never entered.
+
+#define CSAT_NO_LIT     UINT_MAX
+#define CSAT_NO_REASON  UINT_MAX
+
+/********************************/
+/*   CirSat class declaration   */
+/********************************/
+class CirSat
+{
+public:
+   CirSat() { reset(); clearStats(); }
+   ~CirSat() {}
+
+   // Construction (nodes must be created fanins first)
+   void reset();
+   unsigned newNode();
+   void addAnd(unsigned f, unsigned a, bool fa, unsigned b, bool fb);
+   void assertNode(unsigned n, bool val);
+
+   // Search hints: preferred value and decision priority of a node
+   void setPhase(unsigned n, bool val) { _phase[n] = val; }
+   void boostNode(unsigned n, double amount = 1) { _activity[n] += _varInc * amount; }
+
+   // Satisfy all literals of "assumps"; if impossible, the negation of
+   // "assumps" is kept as a clause for later calls
+   bool solve(const vector<unsigned>& assumps);
+   // Return 1/0 from the last satisfying assignment
+   int getValue(unsigned n) const { return _model[n]; }
+
+   void clearStats() { _decisions = _conflicts = _propagations = 0; }
+   void printStats() const;
+
+private:
+   struct CirSatClause {
+      CirSatClause(const vector<unsigned>& l, bool lrn): lits(l), act(0), learnt(lrn) {}
+      vector<unsigned>  lits;
+      float             act;
+      bool              learnt;
+   };
+
+   // Netlist
+   vector<unsigned>           _fanin0;     // CSAT_NO_LIT for free inputs
+   vector<unsigned>           _fanin1;
+   vector<vector<unsigned> >  _fanout;
+   // Assignment
+   vector<char>               _val;        // 0, 1, or 2 (unassigned)
+   vector<int>                _level;
+   vector<unsigned>           _reason;     // gate << 3 | case << 1, or clause << 1 | 1
+   vector<unsigned>           _trail;
+   vector<size_t>             _trailLim;
+   size_t                     _qhead;
+   vector<unsigned>           _jFront;     // AND nodes assigned 0 (justified ones dropped lazily)
+   // Conflict clauses
+   vector<CirSatClause>       _clauses;
+   vector<vector<unsigned> >  _watches;    // clauses watching the negation of a literal
+   size_t                     _learntNum;
+   double                     _claInc;
+   // Decision heuristic
+   vector<double>             _activity;
+   double                     _varInc;
+   vector<char>               _phase;
+   // Scratch
+   vector<char>               _seen;
+   vector<char>               _model;
+   vector<unsigned>           _confl;
+   bool                       _ok;
+   // Statistics
+   size_t                     _decisions;
+   size_t                     _conflicts;
+   size_t                     _propagations;
+
+   int litValue(unsigned l) const { char v = _val[l >> 1]; return v == 2 ? 2 : v ^ (int)(l & 1); }
+   bool isAnd(unsigned n) const { return _fanin0[n] != CSAT_NO_LIT; }
+   int decisionLevel() const { return (int)_trailLim.size(); }
+
+   void assign(unsigned, unsigned);
+   void cancelUntil(int);
+   bool propagate();
+   bool propagateAnd(unsigned);
+   bool propagateClauses(unsigned);
+   void explain(unsigned, vector<unsigned>&);
+   void analyze(vector<unsigned>&, int&);
+   unsigned addClause(const vector<unsigned>&, bool);
+   void addTopClause(vector<unsigned>&);
+   unsigned pickJustify();
+   void bumpNode(unsigned);
+   void reduceDB();
+   void saveModel();
+};
+
+#endif // CIR_SAT_H
@@ -0,0 +1,267 @@
+/****************************************************************************
+  FileName     [ cirSave.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cir snapshot save/load functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2014 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "cirMgr.h"
+#include "cirGate.h"
+
+using namespace std;
+
+// Snapshot layout: every field is 32-bit little-endian except the 64-bit
+// simulation value; all sections are fixed-size records whose counts are
+// in the header, so the file can be mapped and indexed directly.
+//
+//   header   : "FSNP", version, command state, maxVar, #PI, #latch, #PO,
+//              #AIG(file), #AIG(live), #FEC group, dfsStale,
+//              #gate, #fanout, #undef, #dfs, #FEC group entry, #FEC id,
+//              FEC proven
+//   gate     : id, type, lineNo, flags(fraig|inDFS), groNum,
+//              fanin0 lit, fanin1 lit, #fanout, value(64)
+//   fanout   : fanout ids of all gates, in gate order
+//   list     : PI ids, undef ids, dfs ids
+//   FEC      : group sizes, then group members (-1 for removed)
+//   symbol   : length + chars, for every PI then every PO
+
+/*******************************/
+/*   Global variable and enum  */
+/*******************************/
+#define SNAP_VERSION  2
+#define SNAP_NO_LIT   0xffffffff
+
+enum SnapHeader {
+   SNAP_STATE, SNAP_MAXVAR, SNAP_INNUM, SNAP_LATCHNUM, SNAP_OUTNUM,
+   SNAP_ANDNUM, SNAP_AIGNUM, SNAP_FECGROSIZE, SNAP_DFSSTALE,
+   SNAP_GATENUM, SNAP_FANOUTNUM, SNAP_UNDEFNUM, SNAP_DFSNUM,
+   SNAP_FECNUM, SNAP_FECIDNUM, SNAP_FECPROVEN,
+
+   SNAP_HEADER_TOT
+};
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static void
+snapPut(ostream& os, unsigned val)
+{
+	char buf[4];
+	for (size_t i = 0; i < 4; ++i) buf[i] = (char)((val >> (8 * i)) & 0xff);
+	os.write(buf, 4);
+}
+
+class SnapReader
+{
+public:
+	SnapReader(const string& buf): _buf(buf), _pos(0) {}
+	bool get(unsigned& val) {
+		if (_pos + 4 > _buf.size()) return false;
+		val = 0;
+		for (size_t i = 0; i < 4; ++i)
+			val |= (unsigned)(unsigned char)_buf[_pos + i] << (8 * i);
+		_pos += 4; return true;
+	}
+	bool get(string& str, size_t n) {
+		if (_pos + n > _buf.size()) return false;
+		str = _buf.substr(_pos, n); _pos += n; return true;
+	}
+	bool atEnd() const { return _pos == _buf.size(); }
+
+private:
+	const string&  _buf;
+	size_t         _pos;
+};
+
+static unsigned
+snapLit(CirGate* gate, bool inv)
+{
+	if (!gate) return SNAP_NO_LIT;
+	return gate->getGateID() * 2 + (inv ? 1 : 0);
+}
+
+static bool
+snapError(const string& fileName)
+{
+	cerr << "Error: \"" << fileName << "\" is not a valid circuit snapshot!!" << endl;
+	return false;
+}
+
+/**********************************************************/
+/*   class CirMgr member functions for circuit snapshot   */
+/**********************************************************/
+void
+CirMgr::saveSnapshot(ostream& outfile, unsigned state)
+{
+	GateList gates;
+	size_t fanoutNum = 0, fecIdNum = 0;
+	for (size_t i = 0; i < _totList.size(); ++i)
+		if (_totList[i]) { gates.push_back(_totList[i]); fanoutNum += _totList[i]->getOutput().size(); }
+	for (size_t i = 0; i < _fecGroups.size(); ++i) fecIdNum += _fecGroups[i].size();
+
+	/*   Header   */
+	outfile.write("FSNP", 4);
+	snapPut(outfile, SNAP_VERSION);
+	unsigned header[SNAP_HEADER_TOT] = {
+		state, _maxVar, _inNum, _latchNum, _outNum, _andGateNum, (unsigned)_aigNum,
+		(unsigned)_fecGroSize, _dfsStale, (unsigned)gates.size(), (unsigned)fanoutNum,
+		(unsigned)_undefList.size(), (unsigned)_dfsList.size(),
+		(unsigned)_fecGroups.size(), (unsigned)fecIdNum, _fecProven
+	};
+	for (size_t i = 0; i < SNAP_HEADER_TOT; ++i) snapPut(outfile, header[i]);
+
+	/*   Gates and fanouts   */
+	for (size_t i = 0; i < gates.size(); ++i) {
+		CirGate* g = gates[i];
+		size_t val = g->getGateValue();
+		snapPut(outfile, g->getGateID());
+		snapPut(outfile, g->getType());
+		snapPut(outfile, g->getLineNo());
+		snapPut(outfile, (g->hasFraiged() ? 1 : 0) | (g->isInDFS() ? 2 : 0));
+		snapPut(outfile, (unsigned)g->getGroNum());
+		snapPut(outfile, snapLit(g->getInput0(), g->getisInv0()));
+		snapPut(outfile, snapLit(g->getInput1(), g->getisInv1()));
+		snapPut(outfile, g->getOutput().size());
+		snapPut(outfile, (unsigned)val); snapPut(outfile, (unsigned)(val >> 32));
+	}
+	for (size_t i = 0; i < gates.size(); ++i) {
+		GateList outList = gates[i]->getOutput();
+		for (size_t j = 0; j < outList.size(); ++j) snapPut(outfile, outList[j]->getGateID());
+	}
+
+	/*   Lists   */
+	for (size_t i = 0; i < _piList.size(); ++i) snapPut(outfile, _piList[i]->getGateID());
+	for (size_t i = 0; i < _undefList.size(); ++i) snapPut(outfile, _undefList[i]->getGateID());
+	for (size_t i = 0; i < _dfsList.size(); ++i) snapPut(outfile, _dfsList[i]->getGateID());
+	for (size_t i = 0; i < _fecGroups.size(); ++i) snapPut(outfile, _fecGroups[i].size());
+	for (size_t i = 0; i < _fecGroups.size(); ++i)
+		for (size_t j = 0; j < _fecGroups[i].size(); ++j) snapPut(outfile, (unsigned)_fecGroups[i][j]);
+
+	/*   Symbols   */
+	for (size_t i = 0; i < _piList.size() + _poList.size(); ++i) {
+		string symbol = (i < _piList.size() ? _piList[i] : _poList[i - _piList.size()])->getSymbol();
+		snapPut(outfile, symbol.size());
+		outfile.write(symbol.data(), symbol.size());
+	}
+}
+
+bool
+CirMgr::loadSnapshot(const string& fileName, unsigned& state)
+{
+	ifstream snapFile(fileName.c_str(), ios::in | ios::binary);
+	if (!snapFile) {
+		cerr << "Cannot open design \"" << fileName << "\"!!" << endl;
+		return false;
+	}
+	string buf((istreambuf_iterator<char>(snapFile)), istreambuf_iterator<char>());
+	snapFile.close();
+
+	/*   Header   */
+	SnapReader rd(buf);
+	string magic; unsigned version = 0;
+	if (!rd.get(magic, 4) || magic != "FSNP" || !rd.get(version) || version != SNAP_VERSION)
+		return snapError(fileName);
+	unsigned header[SNAP_HEADER_TOT];
+	for (size_t i = 0; i < SNAP_HEADER_TOT; ++i)
+		if (!rd.get(header[i])) return snapError(fileName);
+	state       = header[SNAP_STATE];
+	_maxVar     = header[SNAP_MAXVAR];
+	_inNum      = header[SNAP_INNUM];
+	_latchNum   = header[SNAP_LATCHNUM];
+	_outNum     = header[SNAP_OUTNUM];
+	_andGateNum = header[SNAP_ANDNUM];
+	_aigNum     = header[SNAP_AIGNUM];
+	_fecGroSize = header[SNAP_FECGROSIZE];
+	_dfsStale   = header[SNAP_DFSSTALE];
+	_fecProven  = header[SNAP_FECPROVEN];
+	size_t totSize = (size_t)_maxVar + _outNum + 1;
+	if (header[SNAP_GATENUM] > totSize || _inNum > totSize || _outNum > totSize)
+		return snapError(fileName);
+	_totList.resize(totSize);
+
+	/*   Gates: create first, connect later   */
+	size_t gateNum = header[SNAP_GATENUM];
+	vector<unsigned> records(8 * gateNum);
+	for (size_t i = 0; i < gateNum; ++i) {
+		unsigned* r = &records[8 * i]; unsigned lo = 0, hi = 0;
+		for (size_t j = 0; j < 8; ++j)
+			if (!rd.get(r[j])) return snapError(fileName);
+		if (!rd.get(lo) || !rd.get(hi)) return snapError(fileName);
+		if (r[0] >= totSize || _totList[r[0]]) return snapError(fileName);
+		CirGate* g = 0;
+		switch (r[1]) {
+			case UNDEF_GATE: g = new CirUndefGate; break;
+			case PI_GATE:    g = new CirPIGate;    break;
+			case PO_GATE:    g = new CirPOGate;    break;
+			case AIG_GATE:   g = new CirAIGGate;   break;
+			case CONST_GATE: g = new CirConstGate; break;
+			default: return snapError(fileName);
+		}
+		g->setGateID(r[0]); g->setLineNo(r[2]);
+		g->setFraiged(r[3] & 1); g->setInDFS(r[3] & 2);
+		g->setGroNum((int)r[4]); g->setGateValue((size_t)lo | ((size_t)hi << 32));
+		_totList[r[0]] = g;
+	}
+	for (size_t i = 0; i < _outNum; ++i) {
+		CirGate* po = _totList[_maxVar + i + 1];
+		if (!po || po->getType() != PO_GATE) return snapError(fileName);
+		_poList.push_back(po);
+	}
+	for (size_t i = 0; i < gateNum; ++i) {
+		unsigned* r = &records[8 * i];
+		CirGate* in[2] = { 0, 0 };
+		for (size_t j = 0; j < 2; ++j) {
+			if (r[5 + j] == SNAP_NO_LIT) continue;
+			if (r[5 + j] / 2 >= totSize || !_totList[r[5 + j] / 2]) return snapError(fileName);
+			in[j] = _totList[r[5 + j] / 2];
+		}
+		_totList[r[0]]->setInput(in[0], r[5] & 1, in[1], r[6] & 1);
+	}
+	for (size_t i = 0; i < gateNum; ++i) {
+		unsigned* r = &records[8 * i];
+		for (size_t j = 0; j < r[7]; ++j) {
+			unsigned id = 0;
+			if (!rd.get(id) || id >= totSize || !_totList[id]) return snapError(fileName);
+			_totList[r[0]]->addOutput(_totList[id]);
+		}
+	}
+
+	/*   Lists   */
+	GateList* lists[3] = { &_piList, &_undefList, &_dfsList };
+	size_t listNum[3] = { _inNum, header[SNAP_UNDEFNUM], header[SNAP_DFSNUM] };
+	for (size_t k = 0; k < 3; ++k)
+		for (size_t i = 0; i < listNum[k]; ++i) {
+			unsigned id = 0;
+			if (!rd.get(id) || id >= totSize || !_totList[id]) return snapError(fileName);
+			lists[k]->push_back(_totList[id]);
+		}
+	for (size_t i = 0; i < totSize; ++i)
+		if (_totList[i] && !_totList[i]->isInDFS()) _unlisted.push_back(_totList[i]);
+	_fecGroups.resize(header[SNAP_FECNUM]);
+	for (size_t i = 0; i < _fecGroups.size(); ++i) {
+		unsigned n = 0;
+		if (!rd.get(n) || n > header[SNAP_FECIDNUM]) return snapError(fileName);
+		_fecGroups[i].resize(n);
+	}
+	for (size_t i = 0; i < _fecGroups.size(); ++i)
+		for (size_t j = 0; j < _fecGroups[i].size(); ++j) {
+			unsigned id = 0;
+			if (!rd.get(id) || ((int)id != -1 && id >= totSize)) return snapError(fileName);
+			_fecGroups[i][j] = (int)id;
+		}
+
+	/*   Symbols   */
+	for (size_t i = 0; i < _piList.size() + _poList.size(); ++i) {
+		unsigned n = 0; string symbol;
+		if (!rd.get(n) || !rd.get(symbol, n)) return snapError(fileName);
+		(i < _piList.size() ? _piList[i] : _poList[i - _piList.size()])->setSymbol(symbol);
+	}
+	if (!rd.atEnd()) return snapError(fileName);
+	return true;
+}
@@ -26,6 +26,12 @@ using namespace std;
 // TODO: Keep "CirMgr::randimSim()" and "CirMgr::fileSim()" for cir cmd.
 //       Feel free to define your own variables or functions
 
+#define SIM_EXHAUSTIVE_LIMIT 24   // 2^18 words per gate
+#define SIM_TARGET_GROUPS    16   // Largest groups targeted per round
+#define SIM_TARGET_MEMBERS   8    // Members tried against the lead per group
+#define SIM_TARGET_ROUNDS    32
+#define SIM_TARGET_BUDGET    500  // Conflicts per query; stubborn pairs are left to fraig
+
 /************************************/
 /*   HashKey class implementation   */
 /************************************/
@@ -58,8 +64,10 @@ private:
 void
 CirMgr::randomSim()
 {
-	if (_dfsList.size() == 0) cirDFSearch();
-	valRecordClear();
+	cirDFSFresh();
+	// The pruned rounds need a topological _dfsList
+	cirDFSUpdate();
+	_simCone.clear(); _simConeLive = 0;
 	size_t round = sqrt(_andGateNum); size_t cycle = 0; size_t pattern = 0; bool first = true;
 	if (round > 250) round = round * 2 / 3;
 	if (_fecGroups.size() == 0) {
@@ -87,9 +95,16 @@ CirMgr::randomSim()
 			if (!fecReCheck(true, false, false)) ++cycle;
 		}
 	}
+	// Bring the gates off the cone to the last pattern as well, so the
+	// values are one consistent assignment (fraig starts SAT from them)
+	if (_simConeLive != 0) {
+		CirGate::setGlobalRef();
+		for (unsigned i = 0; i < _poList.size(); ++i)
+			_poList[i]->gateSim();
+		_simCone.clear(); _simConeLive = 0;
+	}
 	fecGroNumSet();
 	cout << pattern * 32 << " patterns simulated." << endl;
-	_randSim = true;
 }
 
 void
@@ -99,88 +114,230 @@ CirMgr::fileSim(ifstream& patternFile)
 		cerr << "Cannot open design \"" << patternFile << "\"!!" << endl;
 		return;
 	}
-	vector<string> simPattern;
-   if (!fileCheck(patternFile, simPattern)) return;
-   
-   if (_dfsList.size() == 0) cirDFSearch();
-   valRecordClear();
-   /*   Simulate input pattern   */
-   size_t round = simPattern.size() / 32; bool oneMoreRound = (simPattern.size() % 32 != 0);
-   bool checkOnce = false;
+   cirDFSFresh();
+   /*   Read, check and simulate input patterns one word (32 patterns) at a time   */
+   vector<size_t> piWords(_piList.size(), 0);
+   size_t patNum = 0; size_t bitNum = 0;
+   bool checkOnce = false; bool patOK = true;
+   string pattern;
    cout << "\r";
-   for (size_t i = 0; i < round; ++i) {
-   	size_t begin = 32 * i; size_t end = 32 * i + 31;
-   	filePISim(simPattern, begin, end); cirFileSim();
-		if (!checkOnce && _fecGroups.size() == 0) { fecCheck(_dfsList, false); checkOnce = true; }
-		else fecReCheck(false, false, false);
+   while (patternFile >> pattern) {
+   	if (!filePatCheck(pattern)) { patOK = false; break; }
+   	for (size_t i = 0; i < _piList.size(); ++i)
+   		piWords[i] = piWords[i] | ((pattern[i] & 1) << bitNum);
+   	if (++bitNum == 32) {
+   		fileWordSim(piWords, bitNum, checkOnce);
+   		patNum += bitNum; bitNum = 0;
+   	}
    }
-   if (oneMoreRound) {
-   	size_t begin = 32 * round; size_t end = 32 * round + (simPattern.size() % 32) - 1;
-   	filePISim(simPattern, begin, end); cirFileSim();
-		if (!checkOnce && _fecGroups.size() == 0) { fecCheck(_dfsList, false); checkOnce = true; }
-		else fecReCheck(false, false, false);
+   if (patOK && bitNum != 0) {
+   	fileWordSim(piWords, bitNum, checkOnce);
+   	patNum += bitNum;
    }
-   fecGroNumSet(); _valPattern = simPattern;
-   cout << simPattern.size() << " patterns simulated." << endl;
-   _randSim = false;
+   patternFile.close(); // close the file
+   fecGroNumSet();
+   cout << patNum << " patterns simulated." << endl;
+}
+
+// Simulate all 2^n input patterns, counting through the PI words, and
+// refine the FEC groups into the exact equivalence classes; false if there
+// are too many PIs. Values are compared with each gate complemented to be
+// 0 under the all-0 pattern, so a pair is in one class only if it is equal
+// (or complemented) under every pattern
+bool
+CirMgr::exhaustiveSim()
+{
+	if (_piList.size() > SIM_EXHAUSTIVE_LIMIT) {
+		cerr << "Error: too many PIs(" << _piList.size() << ") for exhaustive simulation (at most "
+			  << SIM_EXHAUSTIVE_LIMIT << ")!!" << endl;
+		return false;
+	}
+	cirDFSFresh();
+	/*   Classes to refine: the current FEC groups, or all candidates   */
+	vector<IdList> classes;
+	if (_fecGroups.size() == 0) {
+		IdList all;
+		if (!_totList[0]->hasFraiged()) all.push_back(0);
+		for (size_t i = 0; i < _dfsList.size(); ++i)
+			if (_dfsList[i]->isInDFS() && _dfsList[i]->getType() == AIG_GATE && !_dfsList[i]->hasFraiged())
+				all.push_back(_dfsList[i]->getGateID());
+		if (all.size() >= 2) classes.push_back(all);
+	}
+	else for (size_t i = 0; i < _fecGroups.size(); ++i) {
+		IdList members;
+		for (size_t j = 0; j < _fecGroups[i].size(); ++j)
+			if (_fecGroups[i][j] != -1 && _totList[_fecGroups[i][j]]) members.push_back(_fecGroups[i][j]);
+		if (members.size() >= 2) classes.push_back(members);
+	}
+	fecGroNumReset();
+	_fecGroups.resize(0);
+	size_t piNum = _piList.size();
+	size_t wordNum = (piNum > 6 ? (size_t)1 << (piNum - 6) : 1);
+	size_t patNum = (piNum > 6 ? 64 : (size_t)1 << piNum);
+	vector<size_t> flip(_totList.size(), 0);
+	cout << "\r";
+	for (size_t w = 0; w < wordNum; ++w) {
+		for (size_t i = 0; i < piNum; ++i) _piList[i]->setGateValue(cirVarWord(i, w));
+		cirFileSim();
+		if (_simLog) simLogWrite(patNum);
+		if (w == 0)
+			for (size_t c = 0; c < classes.size(); ++c)
+				for (size_t j = 0; j < classes[c].size(); ++j)
+					flip[classes[c][j]] = (_totList[classes[c][j]]->getGateValue() & 1) ? ~(size_t)0 : 0;
+		vector<IdList> next; bool split = false;
+		for (size_t c = 0; c < classes.size(); ++c) {
+			IdList& cls = classes[c];
+			size_t v0 = _totList[cls[0]]->getGateValue() ^ flip[cls[0]];
+			size_t j = 1;
+			while (j < cls.size() && (_totList[cls[j]]->getGateValue() ^ flip[cls[j]]) == v0) ++j;
+			if (j == cls.size()) { next.push_back(IdList()); next.back().swap(cls); continue; }
+			/*   Sort by value (then ID); each run is a new class   */
+			split = true;
+			vector<pair<size_t, unsigned> > kv;
+			for (j = 0; j < cls.size(); ++j)
+				kv.push_back(make_pair(_totList[cls[j]]->getGateValue() ^ flip[cls[j]], cls[j]));
+			sort(kv.begin(), kv.end());
+			for (size_t b = 0, e = 0; b < kv.size(); b = e) {
+				while (e < kv.size() && kv[e].first == kv[b].first) ++e;
+				if (e - b == 1) { _totList[kv[b].second]->setFraiged(true); continue; }
+				next.push_back(IdList());
+				for (size_t k = b; k < e; ++k) next.back().push_back(kv[k].second);
+			}
+		}
+		classes.swap(next);
+		if (split || w == 0) { _fecGroSize = classes.size(); filePrint(); }
+	}
+	for (size_t c = 0; c < classes.size(); ++c)
+		_fecGroups.push_back(intIdList(classes[c].begin(), classes[c].end()));
+	_fecGroSize = _fecGroups.size();
+	_fecProven = true;
+	fecGroNumSet();
+	cout << wordNum * patNum << " patterns simulated." << endl;
+	return true;
 }
 
+// Derive input vectors that split the largest FEC groups: each chosen
+// member is pitted against its lead, by exhaustive simulation of the two
+// cones when their support is small and by a SAT query otherwise. The
+// vectors are packed 64 to a word and simulated like a pattern file (a
+// binary log keeps such a word as two 32-pattern blocks)
 void
-CirMgr::setSimLog(ofstream *logFile)
+CirMgr::targetedSim()
 {
-	if (_simLog) {
-		if (_randSim) randWriteValToStr();
-		else fileWriteValToStr();
-		for (size_t i = 0; i < _valPattern.size(); ++i)
-			(*_simLog) << _valPattern[i] << '\n';
+	size_t patNum = 0;
+	if (_fecProven || _fecGroups.size() == 0) {
+		cout << patNum << " patterns simulated." << endl;
+		return;
+	}
+	cirDFSFresh();
+	_circuitSat = false;
+	_solver.initialize();
+	_solver.setRace(1, 0);
+	genProofModel();
+	vector<Var> piVars(_piList.size());
+	for (size_t j = 0; j < _piList.size(); ++j) piVars[j] = _piList[j]->getVar();
+	// tried[id]: lead + 1 of the last query of "id"; a pair is tried once
+	vector<unsigned> tried(_totList.size(), 0);
+	vector<size_t> piWords(_piList.size(), 0);
+	bool checkOnce = true;
+	cout << "\r";
+	for (size_t r = 0; r < SIM_TARGET_ROUNDS; ++r) {
+		/*   Live members of every group; the largest groups first   */
+		vector<pair<size_t, size_t> > bySize;
+		for (size_t i = 0; i < _fecGroups.size(); ++i) {
+			if (_fecGroups[i][0] == -1 || !_totList[_fecGroups[i][0]]) continue;
+			size_t n = 0;
+			for (size_t j = 1; j < _fecGroups[i].size(); ++j)
+				if (_fecGroups[i][j] != -1 && _totList[_fecGroups[i][j]] && !_totList[_fecGroups[i][j]]->hasFraiged()) ++n;
+			if (n) bySize.push_back(make_pair(n, i));
+		}
+		sort(bySize.rbegin(), bySize.rend());
+		if (bySize.size() > SIM_TARGET_GROUPS) bySize.resize(SIM_TARGET_GROUPS);
+		size_t bitNum = 0;
+		for (size_t g = 0; g < bySize.size() && bitNum < 64; ++g) {
+			const intIdList& group = _fecGroups[bySize[g].second];
+			CirGate* leadGate = _totList[group[0]];
+			IdList members;
+			for (size_t j = 1; j < group.size(); ++j)
+				if (group[j] != -1 && _totList[group[j]] && !_totList[group[j]]->hasFraiged()
+					&& _totList[group[j]]->getVar() != var_Undef && tried[group[j]] != (unsigned)group[0] + 1)
+					members.push_back(group[j]);
+			// A spread of members: neighbours tend to split alike
+			size_t step = members.size() / SIM_TARGET_MEMBERS + 1;
+			vector<SatPair> pairs;
+			for (size_t k = 0; k < members.size() && bitNum < 64; k += step) {
+				CirGate* gate = _totList[members[k]];
+				tried[members[k]] = group[0] + 1;
+				bool isInv = (gate->getGateValue() != leadGate->getGateValue());
+				vector<int> model;
+				SatPairStatus status = solveExact(leadGate, gate, isInv, model);
+				if (status == SAT_PAIR_UNTRIED) {
+					if (leadGate->getVar() != var_Undef)
+						pairs.push_back(SatPair(leadGate->getVar(), gate->getVar(), isInv, k));
+					continue;
+				}
+				if (status != SAT_PAIR_DIFF) continue;
+				for (size_t j = 0; j < _piList.size(); ++j)
+					piWords[j] |= (size_t)(model[j] == -1 ? rand() % 2 : model[j]) << bitNum;
+				++bitNum;
+			}
+			if (pairs.empty()) continue;
+			vector<SatPairResult> results;
+			_solver.solveBatch(pairs, piVars, results, SIM_TARGET_BUDGET, 64 - bitNum);
+			for (size_t k = 0; k < results.size() && bitNum < 64; ++k) {
+				if (results[k].status != SAT_PAIR_DIFF) continue;
+				for (size_t j = 0; j < _piList.size(); ++j) {
+					int bit = results[k].model[j];
+					piWords[j] |= (size_t)(bit == -1 ? rand() % 2 : bit) << bitNum;
+				}
+				++bitNum;
+			}
+		}
+		if (bitNum == 0) break;
+		fileWordSim(piWords, bitNum, checkOnce);
+		patNum += bitNum;
+	}
+	fecGroNumSet();
+	cout << patNum << " patterns simulated." << endl;
+}
+
+// Binary log: "FSIM", #PI, #PO, then one block per 32 patterns:
+// #patterns, #PI words, #PO words (bit k of a word is pattern k).
+// All fields are 32-bit little-endian; a 64-pattern word is two blocks.
+void
+CirMgr::setSimLog(ofstream *logFile, bool binary)
+{
+	_simLog = logFile; _simLogBin = binary;
+	if (_simLog && _simLogBin) {
+		_simLog->write("FSIM", 4);
+		simLogWord(_piList.size()); simLogWord(_poList.size());
 	}
-	_simLog = logFile;
 }
 
 /*************************************************/
 /*   Private member functions about Simulation   */
 /*************************************************/
 bool
-CirMgr::fileCheck(ifstream& patternFile, vector<string>& simPattern)
+CirMgr::filePatCheck(const string& pattern)
 {
-	string strBuf;
-   while (getline(patternFile, strBuf)) {
-   	/*   trim input string   */
-   	size_t begin = strBuf.find_first_not_of(" \t");
-   	size_t end   = strBuf.find_last_not_of(" \t");
-   	if (strBuf.size() >= 2) { strBuf = strBuf.substr(begin, end - begin + 1); }
-   	else if (strBuf.size() == 1 && (strBuf[0] == ' ' || strBuf[0] == '\t')) continue;
-   	else if (strBuf.size() == 0) continue;
-   	for (size_t i = 0; i < strBuf.size(); ++i)
-   		if (strBuf[i] == '\t') strBuf[i] = ' ';
-   	/*   check if string format is right   */
-   	vector<string> tokens; mulTokens(strBuf, tokens);
-   	for (size_t i = 0; i < tokens.size(); ++i) {
-   		/*   check size   */
-			if (tokens[i].size() != _piList.size()) {
-				cout << endl;
-				cerr << "Error: Pattern(" << tokens[i] << ") length(" << tokens[i].size()
-					  << ") does not match the number of inputs("      << _piList.size()
-					  << ") in a circuit!!" << endl;
-				cout << "0 patterns simulated." << endl;
-				return false;
-			}
-			/*   check if string contains non-0/1 character   */
-   		for (size_t j = 0; j < tokens[i].size(); ++j) {
-				if (tokens[i][j] != '0' && tokens[i][j] != '1') {
-					cout << endl;
-					cerr << "Error: Pattern(" << tokens[i] << ") contains a non-0/1 character('" 
-						  << tokens[i][j] << "')." << endl;
-					cout << "0 patterns simulated." << endl;
-					return false;
-				}
-   		}
-   		/*   input pattern   */
-   		simPattern.push_back(tokens[i]);
-   	}
-   }
-   patternFile.close(); // close the file
-   return true;
+	/*   check size   */
+	if (pattern.size() != _piList.size()) {
+		cout << endl;
+		cerr << "Error: Pattern(" << pattern << ") length(" << pattern.size()
+			  << ") does not match the number of inputs("      << _piList.size()
+			  << ") in a circuit!!" << endl;
+		return false;
+	}
+	/*   check if string contains non-0/1 character   */
+	for (size_t j = 0; j < pattern.size(); ++j) {
+		if (pattern[j] != '0' && pattern[j] != '1') {
+			cout << endl;
+			cerr << "Error: Pattern(" << pattern << ") contains a non-0/1 character('" 
+				  << pattern[j] << "')." << endl;
+			return false;
+		}
+	}
+	return true;
 }
 
 void
@@ -188,16 +345,54 @@ CirMgr::cirRandSim()
 {
 	CirGate::setGlobalRef();
 	/* Set value vector of PIs */
-	for (size_t i = 0; i < _piList.size(); ++i) {
-		size_t val = rand();
-		_piList[i]->setGateValue(val);
-		_piValVec.push_back(val);
+	for (size_t i = 0; i < _piList.size(); ++i)
+		_piList[i]->setGateValue(rand());
+	/* Once there are FEC groups, only their fanin cones can split them; */
+	/* the log needs the POs, though                                      */
+	if (_fecGroups.size() != 0 && !_simLog) {
+		size_t live = simLiveCount();
+		// Rebuild the cone when a quarter of its candidates are gone
+		if (_simConeLive == 0 || (live * 4 < _simConeLive * 3 && !_simCone.empty())) simConeUpdate(live);
+		for (size_t i = 0; i < _simCone.size(); ++i)
+			_simCone[i]->simVisit();
+		return;
 	}
 	/* Set value vector of gates of DFS list */
-	if (_poList.size() != 0)
-		for (unsigned i = 0; i < _poList.size(); ++i)
-			_poList[i]->gateSim();
-	else return;
+	for (unsigned i = 0; i < _poList.size(); ++i)
+		_poList[i]->gateSim();
+	if (_simLog) simLogWrite(32);
+}
+
+// Collect the gates of _dfsList in the fanin cones of the "live" FEC
+// candidates, keeping the DFS order
+void
+CirMgr::simConeUpdate(size_t live)
+{
+	vector<bool> need(_totList.size(), false);
+	for (size_t i = 0; i < _fecGroups.size(); ++i)
+		for (size_t j = 0; j < _fecGroups[i].size(); ++j)
+			if (_fecGroups[i][j] != -1 && _totList[_fecGroups[i][j]]) need[_fecGroups[i][j]] = true;
+	for (size_t i = _dfsList.size(); i-- > 0;) {
+		CirGate* g = _dfsList[i];
+		if (!g->isInDFS() || !need[g->getGateID()]) continue;
+		if (g->getInput0()) need[g->getInput0()->getGateID()] = true;
+		if (g->getInput1()) need[g->getInput1()->getGateID()] = true;
+	}
+	_simCone.clear();
+	for (size_t i = 0; i < _dfsList.size(); ++i)
+		if (_dfsList[i]->isInDFS() && need[_dfsList[i]->getGateID()]) _simCone.push_back(_dfsList[i]);
+	_simConeLive = (live ? live : 1);
+}
+
+size_t
+CirMgr::simLiveCount() const
+{
+	size_t live = 0;
+	for (size_t i = 0; i < _fecGroups.size(); ++i)
+		if (_fecGroups[i][0] != -1)
+			for (size_t j = 0; j < _fecGroups[i].size(); ++j)
+				if (_fecGroups[i][j] != -1 && _totList[_fecGroups[i][j]]) ++live;
+	return live;
 }
 
 void
@@ -212,21 +407,16 @@ CirMgr::cirFileSim()
 }
 
 void
-CirMgr::valRecordClear()
-{
-	_piValVec.resize(0); _poValVec.resize(0);
-}
-
-void
-CirMgr::filePISim(vector<string>& simPattern, size_t begin, size_t end)
+CirMgr::fileWordSim(vector<size_t>& piWords, size_t patNum, bool& checkOnce)
 {
 	for (size_t i = 0; i < _piList.size(); ++i) {
-		size_t val = 0;
-		for (size_t j = begin; j <= end; ++j)
-			val = val | ((simPattern[j][i] & 1) << (j % 32));
-		_piList[i]->setGateValue(val);
-		_piValVec.push_back(val);
+		_piList[i]->setGateValue(piWords[i]);
+		piWords[i] = 0;
 	}
+	cirFileSim();
+	if (_simLog) simLogWrite(patNum);
+	if (!checkOnce && _fecGroups.size() == 0) { fecCheck(_dfsList, false); checkOnce = true; }
+	else fecReCheck(false, false, false);
 }
 
 void
@@ -237,61 +427,34 @@ CirMgr::valPISim(vector<size_t>& simPattern, GateList& simPIs)
 }
 
 void
-CirMgr::cycleWrite(vector<string>& tempPattern, vector<size_t> valVec, size_t cycMul, size_t patBegin)
+CirMgr::simLogWrite(size_t patNum)
 {
-	size_t round = valVec.size() / cycMul;
-	size_t cycle = 0;
-	while (cycle < round) {
-		size_t begin = cycle * cycMul; size_t end = ((cycle + 1) * cycMul);
-		for (size_t i = begin; i < end; ++i) {
-			string tempStr = "";
-			for (size_t k = 0; k < 32; ++k) {
-				if ((valVec[i] & (1 << k)) == (size_t)(1 << k)) tempStr += "1";
-				else tempStr += "0";
-			}
-			tempPattern[patBegin + (i % cycMul)] += tempStr;
+	size_t piSize = _piList.size(), poSize = _poList.size();
+	if (_simLogBin) {
+		for (size_t lo = 0; lo < patNum; lo += 32) {
+			simLogWord(patNum - lo < 32 ? patNum - lo : 32);
+			for (size_t i = 0; i < piSize; ++i) simLogWord(_piList[i]->getGateValue() >> lo);
+			for (size_t i = 0; i < poSize; ++i) simLogWord(_poList[i]->getGateValue() >> lo);
 		}
-		++cycle;
+		return;
+	}
+	/*   one line per pattern: PI values, a space, PO values   */
+	string line(piSize + poSize + 1, ' ');
+	for (size_t k = 0; k < patNum; ++k) {
+		for (size_t i = 0; i < piSize; ++i)
+			line[i] = '0' + ((_piList[i]->getGateValue() >> k) & 1);
+		for (size_t i = 0; i < poSize; ++i)
+			line[piSize + 1 + i] = '0' + ((_poList[i]->getGateValue() >> k) & 1);
+		(*_simLog) << line << '\n';
 	}
 }
 
 void
-CirMgr::randWriteValToStr()
-{
-	_valPattern.resize(0);
-	_valPattern.resize(_piList.size() + _poList.size() + 1);
-	size_t piSize = _piList.size();
-	size_t poSize = _poList.size();
-	cycleWrite(_valPattern, _piValVec, piSize, 0);
-	string spaceStr = "";
-	for (size_t i = 0; i < _valPattern[0].size(); ++i) spaceStr += " ";
-	_valPattern[piSize] += spaceStr;
-	cycleWrite(_valPattern, _poValVec, poSize, piSize + 1);
-	strTranpose(_valPattern);
-}
-
-void
-CirMgr::fileWriteValToStr()
-{
-	size_t poSize = _poList.size();
-	vector<string> tempPattern; tempPattern.resize(poSize);
-	cycleWrite(tempPattern, _poValVec, poSize, 0);
-	strTranpose(tempPattern);
-	for (size_t k = 0; k < _valPattern.size(); ++k)
-		_valPattern[k] = _valPattern[k] + " " + tempPattern[k];
-}
-
-void
-CirMgr::strTranpose(vector<string>& tempPattern)
+CirMgr::simLogWord(size_t val)
 {
-	vector<string> ttempPattern;
-	for (size_t i = 0; i < tempPattern[0].size(); ++i) {
-		string tempStr = "";
-		for (size_t j = 0; j < tempPattern.size(); ++j)
-			tempStr += tempPattern[j][i];
-		ttempPattern.push_back(tempStr);
-	}
-	tempPattern = ttempPattern;
+	char buf[4];
+	for (size_t i = 0; i < 4; ++i) buf[i] = (char)((val >> (8 * i)) & 0xff);
+	_simLog->write(buf, 4);
 }
 
 bool
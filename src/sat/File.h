@@ -19,7 +19,7 @@
 // A buffered file abstraction with only 'putChar()' and 'getChar()'.
 
 
-#define File_BufSize 1024   // A small buffer seem to work just as fine as a big one (at least under Linux)
+#define File_BufSize (1 << 20)  // Large enough that proof logging costs one system call per megabyte
 
 enum FileMode { READ, WRITE };
 
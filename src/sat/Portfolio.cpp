@@ -0,0 +1,170 @@
+/*************************************************************************************[Portfolio.C]
+MiniSat -- Copyright (c) 2003-2005, Niklas Een, Niklas Sorensson
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**************************************************************************************************/
+
+#include "Solver.h"
+#include <pthread.h>
+#include <unistd.h>
+
+
+//=================================================================================================
+// Racers:
+
+
+struct Race {
+    volatile bool   stop;       // Set by the first racer with an answer; the others poll it and give up.
+    int             winner;
+    pthread_mutex_t lock;
+};
+
+struct Racer {
+    Solver*         solver;
+    const vec<Lit>* assumps;
+    Race*           race;
+    int             id;
+    lbool           result;
+};
+
+static void* runRacer(void* arg)
+{
+    Racer& r = *(Racer*)arg;
+    r.result = r.solver->solveLimited(*r.assumps);
+    if (r.result != l_Undef){
+        pthread_mutex_lock(&r.race->lock);
+        if (r.race->winner < 0){
+            r.race->winner = r.id;
+            r.race->stop   = true; }
+        pthread_mutex_unlock(&r.race->lock);
+    }
+    return NULL;
+}
+
+
+// Racer 'i' (1, 2, ...) differs from the original in its random seed and frequency, restart policy
+// and phase selection:
+static void configureRacer(Solver& s, int i)
+{
+    SearchParams& p = s.default_params;
+    p.random_var_freq = 0.02 * (1 + i % 3);
+    p.restarts        = (i % 3 == 1) ? restart_luby : (i % 3 == 2) ? restart_glucose : restart_geometric;
+    p.lbd_tiers       = (i % 3 == 2);
+    p.phase_saving    = (i % 2 == 1);
+    s.setSeed(91648253.0 + 7919.0 * i);
+}
+
+
+//=================================================================================================
+// Cloning:
+
+
+// Copy the problem as it stands at the top level into the fresh solver 'to': variables, their
+// activity, polarity and preprocessing status, the top-level units and the problem clauses. Learnt
+// clauses are left behind, and so is the proof log.
+//
+void Solver::copyProblem(Solver& to)
+{
+    assert(decisionLevel() == 0 && to.nVars() == 0);
+    to.default_params   = default_params;
+    to.expensive_ccmin  = expensive_ccmin;
+    to.luby_unit        = luby_unit;
+    for (int i = 0; i < nVars(); i++){
+        to.newVar();
+        to.activity[i]   = activity[i] / var_inc;
+        to.order.update(i);
+        to.polarity[i]   = polarity[i];
+        to.frozen[i]     = frozen[i];
+        to.eliminated[i] = eliminated[i]; }
+    elimclauses.copyTo(to.elimclauses);
+
+    for (int i = 0; i < trail.size(); i++)
+        to.addUnit(trail[i]);
+    vec<Lit> ps;
+    for (int i = 0; i < clauses.size(); i++){
+        const Clause& c = ca[clauses[i]];
+        if (c.removed()) continue;
+        ps.clear();
+        for (int j = 0; j < c.size(); j++) ps.push(c[j]);
+        to.addClause(ps); }
+}
+
+
+//=================================================================================================
+// Portfolio solving:
+
+
+// Like 'solveLimited()', but a query still open after 'first_budget' conflicts is raced by this
+// solver and up to 'n_racers - 1' differently configured clones (one per processor at most) on
+// separate threads. The first answer wins; its model or conflict is taken over, and the others are
+// stopped through 'interrupt'. 'conflict_budget' still bounds each racer. Proof logging disables
+// racing, since the clones do not log.
+//
+lbool Solver::solveRace(const vec<Lit>& assumps, int n_racers, int64 first_budget)
+{
+    int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < n_racers) n_racers = cpus;
+    if (n_racers <= 1 || proof != NULL || (conflict_budget >= 0 && conflict_budget <= first_budget))
+        return solveLimited(assumps);
+
+    int64 budget = conflict_budget;
+    int64 start  = stats.conflicts;
+    conflict_budget = first_budget;
+    lbool result = solveLimited(assumps);
+    conflict_budget = budget;
+    if (result != l_Undef) return result;
+    int64 rest = budget < 0 ? -1 : budget - (stats.conflicts - start);
+
+    Race race;
+    race.stop   = false;
+    race.winner = -1;
+    pthread_mutex_init(&race.lock, NULL);
+
+    vec<Solver*>    solvers;
+    vec<Racer>      racers;
+    vec<pthread_t>  threads;
+    solvers.push(this);
+    for (int i = 1; i < n_racers; i++){
+        Solver* s = new Solver();
+        copyProblem(*s);
+        configureRacer(*s, i);
+        solvers.push(s); }
+    for (int i = 0; i < n_racers; i++){
+        solvers[i]->conflict_budget = rest;
+        solvers[i]->interrupt       = &race.stop;
+        Racer r = { solvers[i], &assumps, &race, i, l_Undef };
+        racers.push(r); }
+
+    threads.growTo(n_racers);
+    for (int i = 1; i < n_racers; i++)
+        if (pthread_create(&threads[i], NULL, runRacer, &racers[i]) != 0)
+            racers[i].solver = NULL;
+    runRacer(&racers[0]);           // (this solver races on the calling thread)
+    for (int i = 1; i < n_racers; i++)
+        if (racers[i].solver != NULL) pthread_join(threads[i], NULL);
+
+    interrupt       = NULL;
+    conflict_budget = budget;
+    result          = race.winner < 0 ? l_Undef : racers[race.winner].result;
+    if (race.winner > 0){
+        Solver& w = *solvers[race.winner];
+        if (result == l_True) w.model.copyTo(model);
+        else                  w.conflict.copyTo(conflict); }
+    for (int i = 1; i < n_racers; i++)
+        delete solvers[i];
+    pthread_mutex_destroy(&race.lock);
+    return result;
+}
@@ -0,0 +1,313 @@
+/************************************************************************************[Preprocess.C]
+MiniSat -- Copyright (c) 2003-2005, Niklas Een, Niklas Sorensson
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+associated documentation files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge, publish, distribute,
+sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or
+substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT
+OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+**************************************************************************************************/
+
+#include "Solver.h"
+#include "Sort.h"
+
+
+//=================================================================================================
+// Helpers:
+
+
+struct elimOrder_lt {   // Cheapest variables (fewest possible resolvents) first.
+    const vec<int>& n_occ;
+    elimOrder_lt(const vec<int>& n) : n_occ(n) {}
+    bool operator () (Var x, Var y) {
+        return (int64)n_occ[index(Lit(x))] * n_occ[index(~Lit(x))] < (int64)n_occ[index(Lit(y))] * n_occ[index(~Lit(y))]; }
+};
+
+
+// Add a problem clause and, if it is kept as a clause, register it for subsumption. A resulting
+// unit is propagated at once. Returns FALSE if the problem became unsatisfiable.
+//
+bool Solver::addClauseOcc(const vec<Lit>& ps)
+{
+    int n = clauses.size();
+    newClause(ps);
+    if (!ok) return false;
+    if (clauses.size() > n){
+        CRef          cr = clauses.last();
+        const Clause& c  = ca[cr];
+        for (int i = 0; i < c.size(); i++){
+            occurs[var(c[i])].push(cr);
+            n_occ[index(c[i])]++; }
+        subsumption_queue.push(cr);
+    }else if (propagate() != CRef_Undef)
+        ok = false;
+    return ok;
+}
+
+
+// Remove a problem clause. It stays in 'occurs[]' and 'clauses' until the end of 'preprocess()'
+// but is recognized by 'removed()'.
+//
+void Solver::removeClauseOcc(CRef cr)
+{
+    const Clause& c = ca[cr];
+    for (int i = 0; i < c.size(); i++){
+        n_occ[index(c[i])]--;
+        if (reason[var(c[i])] == cr)        // (top-level reasons are never looked at)
+            reason[var(c[i])] = CRef_Undef;
+    }
+    remove(cr);
+}
+
+
+// Returns 'lit_Undef' if 'c' subsumes 'd', the literal 'p' if 'c' with 'p' flipped subsumes 'd'
+// (so 'd' can be strengthened by removing '~p'), and 'lit_Error' otherwise.
+//
+Lit Solver::subsumes(const Clause& c, const Clause& d) const
+{
+    if (c.size() > d.size()) return lit_Error;
+    Lit ret = lit_Undef;
+    for (int i = 0; i < c.size(); i++){
+        for (int j = 0; j < d.size(); j++)
+            if (c[i] == d[j])
+                goto Found;
+            else if (ret == lit_Undef && c[i] == ~d[j]){
+                ret = c[i];
+                goto Found; }
+        return lit_Error;
+      Found:;
+    }
+    return ret;
+}
+
+
+// Replace clause 'cr' by the same clause without literal 'p' (self-subsuming resolution).
+//
+bool Solver::strengthen(CRef cr, Lit p)
+{
+    vec<Lit> lits;
+    const Clause& c = ca[cr];
+    for (int i = 0; i < c.size(); i++)
+        if (c[i] != p) lits.push(c[i]);
+    removeClauseOcc(cr);
+    return addClauseOcc(lits);
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  backwardSubsumption : [void]  ->  [bool]
+|  
+|  Description:
+|    For every clause in 'subsumption_queue', remove the clauses it subsumes and strengthen the
+|    clauses it subsumes with one literal flipped. Only the occurrences of its least frequent
+|    variable need to be looked at. Returns FALSE if the problem became unsatisfiable.
+|________________________________________________________________________________________________@*/
+bool Solver::backwardSubsumption()
+{
+    while (subsumption_queue.size() > 0){
+        CRef cr = subsumption_queue.last(); subsumption_queue.pop();
+        if (ca[cr].removed()) continue;
+
+        Var best = var(ca[cr][0]);
+        for (int i = 1; i < ca[cr].size(); i++)
+            if (occurs[var(ca[cr][i])].size() < occurs[best].size())
+                best = var(ca[cr][i]);
+
+        // (strengthening may add to 'occurs[best]' and move the clause region -- re-read every time)
+        for (int j = 0; j < occurs[best].size() && !ca[cr].removed(); j++){
+            CRef dr = occurs[best][j];
+            if (dr == cr || ca[dr].removed()) continue;
+            Lit l = subsumes(ca[cr], ca[dr]);
+            if (l == lit_Undef)
+                removeClauseOcc(dr);
+            else if (l != lit_Error && !strengthen(dr, ~l))
+                return false;
+        }
+    }
+    return true;
+}
+
+
+// Resolve 'ps' and 'qs' on 'v' into 'out'. Returns FALSE if the resolvent is a tautology.
+//
+bool Solver::merge(const Clause& ps, const Clause& qs, Var v, vec<Lit>& out) const
+{
+    out.clear();
+    for (int i = 0; i < qs.size(); i++){
+        if (var(qs[i]) == v) continue;
+        for (int j = 0; j < ps.size(); j++)
+            if (var(ps[j]) == var(qs[i])){
+                if (ps[j] == ~qs[i]) return false;
+                goto Next; }
+        out.push(qs[i]);
+      Next:;
+    }
+    for (int i = 0; i < ps.size(); i++)
+        if (var(ps[i]) != v) out.push(ps[i]);
+    return true;
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  eliminateVar : (v : Var)  ->  [bool]
+|  
+|  Description:
+|    Bounded variable elimination: replace all clauses on 'v' by their non-tautological resolvents
+|    on 'v', provided there are no more of them than clauses removed and none is longer than
+|    'elim_clause_lim'. The removed clauses are kept in 'elimclauses' for 'extendModel()'.
+|    Returns FALSE if the problem became unsatisfiable.
+|________________________________________________________________________________________________@*/
+bool Solver::eliminateVar(Var v)
+{
+    if (frozen[v] || eliminated[v] || value(v) != l_Undef) return true;
+
+    vec<CRef>   pos, neg;
+    for (int i = 0; i < occurs[v].size(); i++){
+        CRef cr = occurs[v][i];
+        if (ca[cr].removed()) continue;
+        const Clause& c = ca[cr];
+        for (int j = 0; j < c.size(); j++)
+            if (var(c[j]) == v){
+                (sign(c[j]) ? neg : pos).push(cr);
+                break; }
+    }
+
+    // Check that the number of clauses does not grow:
+    vec<Lit>    resolvent;
+    int         cnt = 0;
+    for (int i = 0; i < pos.size(); i++)
+        for (int j = 0; j < neg.size(); j++)
+            if (merge(ca[pos[i]], ca[neg[j]], v, resolvent)
+             && (++cnt > pos.size() + neg.size() || resolvent.size() > elim_clause_lim))
+                return true;
+
+    // Keep the clauses for model extension, then replace them by the resolvents:
+    eliminated[v] = 1;
+    for (int type = 0; type < 2; type++){
+        vec<CRef>& cs = type ? neg : pos;
+        for (int i = 0; i < cs.size(); i++){
+            const Clause& c = ca[cs[i]];
+            elimclauses.push(index(type ? ~Lit(v) : Lit(v)));
+            for (int j = 0; j < c.size(); j++)
+                if (var(c[j]) != v) elimclauses.push(index(c[j]));
+            elimclauses.push(c.size());
+        }
+    }
+    for (int i = 0; i < pos.size(); i++) removeClauseOcc(pos[i]);
+    for (int i = 0; i < neg.size(); i++) removeClauseOcc(neg[i]);
+    occurs[v].clear(true);
+
+    // (removed clauses stay readable until the next garbage collection)
+    for (int i = 0; i < pos.size(); i++)
+        for (int j = 0; j < neg.size(); j++)
+            if (merge(ca[pos[i]], ca[neg[j]], v, resolvent) && !addClauseOcc(resolvent))
+                return false;
+    return true;
+}
+
+
+//=================================================================================================
+// Public interface:
+
+
+/*_________________________________________________________________________________________________
+|
+|  preprocess : [void]  ->  [bool]
+|  
+|  Description:
+|    Simplify the problem clauses at the top level before a batch of queries: backward subsumption,
+|    self-subsuming resolution and bounded elimination of every variable that is not frozen.
+|    Learnt clauses are dropped (they are implied by the problem clauses anyway). Models returned
+|    by 'solve()' afterwards are extended to the eliminated variables. Skipped when logging proofs.
+|    Returns FALSE if the problem is unsatisfiable.
+|________________________________________________________________________________________________@*/
+bool Solver::preprocess()
+{
+    if (!ok || proof != NULL) return ok;
+    assert(decisionLevel() == 0);
+    if (propagate() != CRef_Undef){
+        ok = false;
+        return false; }
+
+    // Top-level reasons are never looked at; forget them so that every clause may go:
+    for (int i = 0; i < trail.size(); i++)
+        reason[var(trail[i])] = CRef_Undef;
+    for (int i = 0; i < learnts.size(); i++)
+        remove(learnts[i]);
+    learnts.clear();
+
+    // Occurrence lists (satisfied clauses are dropped right away):
+    occurs.growTo(nVars());
+    n_occ .growTo(2 * nVars(), 0);
+    for (int i = 0; i < clauses.size(); i++){
+        CRef cr = clauses[i];
+        if (simplify(ca[cr])){
+            remove(cr);
+            continue; }
+        const Clause& c = ca[cr];
+        for (int j = 0; j < c.size(); j++){
+            occurs[var(c[j])].push(cr);
+            n_occ[index(c[j])]++; }
+        subsumption_queue.push(cr);
+    }
+
+    if (backwardSubsumption()){
+        vec<Var> order_elim;
+        for (Var v = 0; v < nVars(); v++)
+            if (!frozen[v] && !eliminated[v] && value(v) == l_Undef)
+                order_elim.push(v);
+        sort(order_elim, elimOrder_lt(n_occ));
+        for (int i = 0; i < order_elim.size(); i++)
+            if (!eliminateVar(order_elim[i]) || !backwardSubsumption())
+                break;
+    }
+
+    // Clean up:
+    int j = 0;
+    for (int i = 0; i < clauses.size(); i++)
+        if (!ca[clauses[i]].removed())
+            clauses[j++] = clauses[i];
+    clauses.shrink(clauses.size() - j);
+    for (int i = 0; i < occurs.size(); i++)
+        occurs[i].clear(true);
+    occurs.clear(true);
+    n_occ.clear(true);
+    subsumption_queue.clear(true);
+    checkGarbage();
+    return ok;
+}
+
+
+// Give the eliminated variables values satisfying their removed clauses, latest elimination first.
+//
+void Solver::extendModel()
+{
+    for (int i = 0; i < nVars(); i++)
+        if (eliminated[i] && model[i] == l_Undef)
+            model[i] = l_False;
+
+    int i, j;
+    for (i = elimclauses.size()-1; i > 0; i -= j){
+        for (j = elimclauses[i--]; j > 1; j--, i--){
+            Lit p = toLit(elimclauses[i]);
+            if ((sign(p) ? ~model[var(p)] : model[var(p)]) != l_False)
+                goto Next;
+        }
+        {
+        Lit x = toLit(elimclauses[i]);
+        model[var(x)] = lbool(!sign(x));
+        }
+      Next:;
+    }
+}
@@ -40,13 +40,12 @@ public:
     //
     char* open(File& fp)
     {
-//        char * name;
-        char*   name = "/tmp/fileXXXXXX";
         for(;;){
 //            name = tempnam(NULL, NULL);     // (gcc complains about this... stupid gcc...)
 //            fp.open(name, "wx+");
-            fp.open( mkstemp(name) , WRITE , true );
+            char*   name = strdup("/tmp/fileXXXXXX");     // ('mkstemp()' writes into the template)
             assert(name != NULL);
+            fp.open( mkstemp(name) , WRITE , true );
             if (fp.null())
                 xfree(name);
             else{
@@ -68,6 +67,7 @@ Proof::Proof()
     fp_name    = temp_files.open(fp);
     id_counter = 0;
     trav       = NULL;
+    n_vars     = 0;
     TRA_INT    = 0;
     fpos =0 ;
 }
@@ -77,11 +77,32 @@ Proof::Proof(ProofTraverser& t)
 {
     id_counter = 0;
     trav       = &t;
+    n_vars     = 0;
     TRA_INT    = 0;
     fpos = 0;
 }
 
 
+#define Proof_Magic "MPRF"
+
+Proof::Proof(cchar* filename)
+{
+    fp_name    = NULL;
+    id_counter = 0;
+    trav       = NULL;
+    n_vars     = 0;
+    TRA_INT    = 0;
+    fpos       = 0;
+    fp.open(filename, "w+");
+    if (!fp.null()){
+        for (cchar* p = Proof_Magic; *p; p++) fp.putChar(*p);
+        putUInt(fp, 3);     // (format version)
+        fp.flush();
+        fpos = fp.tell();   // ('traverse()' starts after the header)
+    }
+}
+
+
 ClauseId Proof::addRoot(vec<Lit>& cl, bool A)
 {
     cl.copyTo(clause);
@@ -151,6 +172,80 @@ void Proof::deleted(ClauseId gone)
 }
 
 
+// The events below introduce no clause. A chain or deletion never refers to 'id_counter' itself,
+// so distance 0 (a bare 1) starts them, followed by the kind: 0 end, 1 solver, 2 query, 3 merge,
+// 4 variables.
+//
+void Proof::newSolver()
+{
+    n_vars = 0;
+    if (trav != NULL)
+        trav->newSolver();
+    if (!fp.null()){
+        putUInt(fp, 1);
+        putUInt(fp, 1);
+    }
+}
+
+
+void Proof::vars(int n)
+{
+    if (n <= n_vars) return;
+    n_vars = n;
+    if (trav != NULL)
+        trav->vars(n);
+    if (!fp.null()){
+        putUInt(fp, 1);
+        putUInt(fp, 4);
+        putUInt(fp, n);
+    }
+}
+
+
+void Proof::query(ClauseId c, Lit act, Lit a, Lit b)
+{
+    if (c == ClauseId_NULL || c < 0 || c >= id_counter)
+        return;     // (not refuted; a merge on it will not check)
+    if (trav != NULL)
+        trav->query(c, act, a, b);
+    if (!fp.null()){
+        putUInt(fp, 1);
+        putUInt(fp, 2);
+        putUInt(fp, id_counter - c);
+        putUInt(fp, index(act));
+        putUInt(fp, index(a));
+        putUInt(fp, index(b));
+    }
+}
+
+
+void Proof::merge(unsigned x, unsigned y, Lit a, Lit b)
+{
+    if (trav != NULL)
+        trav->merge(x, y, a, b);
+    if (!fp.null()){
+        putUInt(fp, 1);
+        putUInt(fp, 3);
+        putUInt(fp, x);
+        putUInt(fp, y);
+        putUInt(fp, index(a));
+        putUInt(fp, index(b));
+    }
+}
+
+
+void Proof::end()
+{
+    if (trav != NULL)
+        trav->done();
+    if (!fp.null()){
+        putUInt(fp, 1);
+        putUInt(fp, 0);
+        fp.flush();
+    }
+}
+
+
 //=================================================================================================
 // Read-back methods:
 
@@ -185,6 +280,85 @@ bool Proof::save(cchar* filename)
 }
 
 
+// Read the next record and pass it on to 'trav'. A deletion or an event introduces no clause, so
+// 'id' is moved back by one. Returns FALSE at the end of the proof or of the file, or on an event
+// of unknown kind (the file is corrupt).
+//
+bool Proof::readRecord(ProofTraverser& trav, ClauseId& id)
+{
+    uint64  tmp;
+    uint64  idx;
+    bool    A;
+
+    if (fp.eof()) return false;
+    tmp = getUInt(fp);
+    if (tmp == 1){
+        // Event:
+        ClauseId at = id--;
+        switch (getUInt(fp)){
+        case 0:
+            trav.done();
+            return false;
+        case 1:
+            trav.newSolver();
+            break;
+        case 2:{
+            ClauseId c = at - (ClauseId)getUInt(fp);
+            Lit act = toLit(getUInt(fp));
+            Lit a   = toLit(getUInt(fp));
+            Lit b   = toLit(getUInt(fp));
+            trav.query(c, act, a, b);
+            break; }
+        case 3:{
+            unsigned x = getUInt(fp);
+            unsigned y = getUInt(fp);
+            Lit a   = toLit(getUInt(fp));
+            Lit b   = toLit(getUInt(fp));
+            trav.merge(x, y, a, b);
+            break; }
+        case 4:
+            trav.vars(getUInt(fp));
+            break;
+        default:
+            return false;
+        }
+
+    }else if ((tmp & 1) == 0){
+        // Root clause:
+        clause.clear();
+        for (idx = tmp >> 1;; idx += tmp){
+            if (idx > INT_MAX) return false;    // (no such literal; the file is corrupt)
+            clause.push(toLit((int)idx));
+            tmp = getUInt(fp);
+            if (tmp == 0) break;
+        }
+        if( getUInt(fp) == 1 ) A = true;
+        else A = false;
+        trav.root(clause ,A);
+
+    }else{
+        // Derivation or Deletion:
+        chain_id .clear();
+        chain_lit.clear();
+        chain_id.push(id - (tmp >> 1));
+        for(;;){
+            tmp = getUInt(fp);
+            if (tmp == 0) break;
+            chain_lit.push(toLit( tmp - 1));
+            tmp = getUInt(fp);
+            chain_id.push(id - tmp);
+        }
+
+        if (chain_lit.size() == 0)
+            id--,   // (no new clause introduced)
+            trav.deleted(chain_id[0]);
+        else
+            trav.chain(chain_id, chain_lit);
+    }
+    return true;
+}
+
+
 void Proof::traverse(ProofTraverser& trav, ClauseId goal)
 {
     assert(!fp.null());
@@ -197,52 +371,179 @@ void Proof::traverse(ProofTraverser& trav, ClauseId goal)
     if (goal == ClauseId_NULL)
         goal = last();
 
-    uint64  tmp;
-    int     idx;
-    bool    A; 
-
-    for(ClauseId id = TRA_INT ; id <= goal; id++){
-        tmp = getUInt(fp);
-        if ((tmp & 1) == 0){
-            // Root clause:
-            clause.clear();
-            idx = tmp >> 1;
-            clause.push(toLit(idx));
-            for(;;){
-                tmp = getUInt(fp);
-                if (tmp == 0) break;
-                idx += tmp;
-                clause.push(toLit(idx));
-            }
-            if( getUInt(fp) == 1 ) A = true;
-            else A = false;
-            //assert( false);
-            trav.root(clause ,A);
-        
-
-        }else{
-            // Derivation or Deletion:
-            
-            chain_id .clear();
-            chain_lit.clear();
-            chain_id.push(id - (tmp >> 1));
-            for(;;){
-                tmp = getUInt(fp);
-                if (tmp == 0) break;
-                chain_lit.push(toLit( tmp - 1));
-                tmp = getUInt(fp);
-                chain_id.push(id - tmp);
-            }
-
-            if (chain_lit.size() == 0)
-                id--,   // (no new clause introduced)
-                trav.deleted(chain_id[0]);
-            else
-                trav.chain(chain_id, chain_lit);
-        }
-    }
+    for(ClauseId id = TRA_INT ; id <= goal; id++)
+        if (!readRecord(trav, id)) break;
     TRA_INT = goal+1;
     fpos = fp.tell();
     fp.seek(0, SEEK_END);
     fp.setMode(WRITE);
 }
+
+
+bool Proof::replay(cchar* filename, ProofTraverser& trav)
+{
+    Proof   p(trav);
+    p.fp.open(filename, "r");
+    if (p.fp.null())
+        return false;
+    for (cchar* q = Proof_Magic; *q; q++)
+        if (p.fp.getChar() != (uchar)*q)
+            return false;
+    try{
+        if (getUInt(p.fp) != 3)
+            return false;
+    }catch (Exception_EOF){
+        return false; }
+    try{
+        for (ClauseId id = 0; p.readRecord(trav, id); id++);
+    }catch (Exception_EOF){}    // (truncated: 'done()' is never reached)
+    return true;
+}
+
+
+//=================================================================================================
+// ProofChecker:
+
+
+void ProofChecker::root(const vec<Lit>& c, bool A)
+{
+    bool    ok = true;
+    for (int i = 0; i < c.size(); i++)
+        if (!declared(c[i])) ok = false;
+    roots++;
+    clauses.push();
+    if (!check(ok)){
+        gone.push(1);
+        sound.push(0);
+        return; }
+    for (int i = 0; i < c.size(); i++){
+        occ.growTo(var(c[i]) + 1);
+        if (occ[var(c[i])].size() < 3) occ[var(c[i])].push(clauses.size() - 1);
+    }
+    c.copyTo(clauses.last());
+    gone.push(0);
+    sound.push(1);
+}
+
+
+void ProofChecker::chain(const vec<ClauseId>& cs, const vec<Lit>& xs)
+{
+    bool    in_range = true;
+    for (int i = 0; i < cs.size(); i++)
+        if (!known(cs[i])) in_range = false;
+    for (int i = 0; i < xs.size(); i++)
+        if (!declared(xs[i])) in_range = false;
+    if (!check(in_range)){
+        clauses.push();
+        gone.push(1);
+        sound.push(0);
+        chains++;
+        return; }
+
+    bool    ok = valid(cs[0]);
+    bool    all_sound = true;
+    for (int i = 0; i < cs.size(); i++)
+        if (!valid(cs[i]) || !sound[cs[i]]) all_sound = false;
+    resolvent.clear();
+    if (ok){
+        const vec<Lit>& c = clauses[cs[0]];
+        for (int i = 0; i < c.size(); i++)
+            if (!marked(c[i])) markLit(c[i]), resolvent.push(c[i]);
+    }
+
+    for (int i = 0; ok && i < xs.size(); i++){
+        if (!valid(cs[i+1])){ ok = false; break; }
+        const vec<Lit>& c = clauses[cs[i+1]];
+        Lit     p = marked(Lit(var(xs[i]))) ? Lit(var(xs[i])) : ~Lit(var(xs[i]));     // (pivot as in the resolvent)
+        bool    found = false;
+        for (int j = 0; j < c.size(); j++)
+            if (c[j] == ~p) found = true;
+        if (!marked(p) || !found){ ok = false; break; }
+        mark[index(p)] = 0;     // (the resolvent is filtered on 'mark' below)
+        for (int j = 0; j < c.size(); j++)
+            if (c[j] != ~p && !marked(c[j]))
+                markLit(c[j]), resolvent.push(c[j]);
+    }
+
+    clauses.push();
+    gone.push(0);
+    sound.push(ok && all_sound);
+    for (int i = 0; i < resolvent.size(); i++)
+        if (marked(resolvent[i]))
+            mark[index(resolvent[i])] = 0,
+            clauses.last().push(resolvent[i]);
+    chains++;
+    if (!ok){
+        if (bad++ == 0) first_bad = clauses.size() - 1; }
+}
+
+
+void ProofChecker::deleted(ClauseId c)
+{
+    if (check(known(c)) && valid(c)){
+        gone[c] = 1;
+        clauses[c].clear(true); }
+    deletions++;
+}
+
+
+void ProofChecker::newSolver()
+{
+    for (int i = 0; i < clauses.size(); i++)
+        if (!gone[i])
+            gone[i] = 1,
+            clauses[i].clear(true);
+    occ.clear(true);
+    proven.clear(true);
+    n_vars = 0;
+}
+
+
+void ProofChecker::vars(int n)
+{
+    if (check(n > n_vars)) n_vars = n;
+}
+
+
+// TRUE if clause 'id' is exactly '{p, q, r}'.
+bool ProofChecker::isMiter(ClauseId id, Lit p, Lit q, Lit r) const
+{
+    if (!valid(id) || clauses[id].size() != 3) return false;
+    const vec<Lit>& c = clauses[id];
+    for (int i = 0; i < 3; i++)
+        if (c[i] != p && c[i] != q && c[i] != r) return false;
+    return c[0] != c[1] && c[1] != c[2] && c[0] != c[2];
+}
+
+
+void ProofChecker::query(ClauseId c, Lit act, Lit a, Lit b)
+{
+    queries++;
+    if (!check(known(c) && declared(act) && declared(a) && declared(b))) return;
+    if (!valid(c) || !sound[c]) return;
+    for (int i = 0; i < clauses[c].size(); i++)
+        if (clauses[c][i] != ~act) return;
+    // 'act' must be fresh: its only roots are those of 'act -> (a != b)' (one is left out if it
+    // was satisfied when added)
+    Var x = var(act);
+    if (x >= occ.size() || occ[x].size() == 0 || occ[x].size() > 2) return;
+    bool pos = false, neg = false;
+    for (int i = 0; i < occ[x].size(); i++)
+        if (!pos && isMiter(occ[x][i], ~act, a, b)) pos = true;
+        else if (!neg && isMiter(occ[x][i], ~act, ~a, ~b)) neg = true;
+        else return;
+    proven.push(a);
+    proven.push(b);
+}
+
+
+void ProofChecker::merge(unsigned x, unsigned y, Lit a, Lit b)
+{
+    merges++;
+    if (!check(declared(a) && declared(b))) return;
+    for (int i = proven.size() - 2; i >= 0; i -= 2)
+        if ((proven[i] == a && proven[i+1] == b) || (proven[i] == b && proven[i+1] == a))
+            return;
+    if (unproven++ == 0)
+        first_x = x, first_y = y;
+}
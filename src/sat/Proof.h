@@ -31,10 +31,19 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 // (offline mode) this class.  Each call to 'root()' or 'chain()' produces a new clause. The first
 // clause has ID 0, the next 1 and so on. These are the IDs passed to 'chain()'s 'cs' parameter.
 //
+// The other events introduce no clause: 'newSolver()' starts a new clause database (the IDs go
+// on counting), 'vars()' says it has 'n' variables so far, 'query()' says clause 'c' refutes the
+// miter 'act -> (a != b)', and 'merge()' says the caller merged its objects 'x' and 'y' because
+// 'a == b'. 'done()' marks the end of the proof.
+//
 struct ProofTraverser {
     virtual void root   (const vec<Lit>& c , bool A)=0;// {assert(false);};
     virtual void chain  (const vec<ClauseId>& cs, const vec<Lit>& xs)=0;// {assert(false);};
     virtual void deleted(ClauseId c){}
+    virtual void newSolver(){}
+    virtual void vars   (int n){}
+    virtual void query  (ClauseId c, Lit act, Lit a, Lit b){}
+    virtual void merge  (unsigned x, unsigned y, Lit a, Lit b){}
     virtual void done   ()=0;//{assert(false);}
     virtual ~ProofTraverser(){}
 };
@@ -45,6 +54,7 @@ class Proof {
     cchar*          fp_name;
     ClauseId        id_counter;
     ProofTraverser* trav;
+    int             n_vars;         // Variables declared to the current database.
 
     int             TRA_INT;
     int64           fpos;
@@ -53,20 +63,91 @@ class Proof {
     vec<ClauseId>   chain_id;
     vec<Lit>        chain_lit;
 
+    bool            readRecord(ProofTraverser& trav, ClauseId& id);
+
 public:
     Proof();                        // Offline mode -- proof stored to a file, which can be saved, compressed, and/or traversed.
     Proof(ProofTraverser& t);       // Online mode -- proof will not be stored.
+    Proof(cchar* filename);         // Offline mode, storing to 'filename' (with a header) so that it can be replayed later.
+
+    bool     null      () { return trav == NULL && fp.null(); }    // TRUE if the proof file could not be created.
 
     ClauseId addRoot   (vec<Lit>& clause , bool A );
     void     beginChain(ClauseId start);
     void     resolve   (ClauseId next, Lit x);
     ClauseId endChain  ();
     void     deleted   (ClauseId gone);
+    void     newSolver ();
+    void     vars      (int n);     // Declare 'n' variables (once they exceed the last declaration).
+    void     query     (ClauseId c, Lit act, Lit a, Lit b);
+    void     merge     (unsigned x, unsigned y, Lit a, Lit b);
+    void     end       ();
     ClauseId last      () { assert(id_counter != ClauseId_NULL); return id_counter - 1; }
 
     void     compress  (Proof& dst, ClauseId goal = ClauseId_NULL);     // 'dst' should be a newly constructed, empty proof.
     bool     save      (cchar* filename);
     void     traverse  (ProofTraverser& trav, ClauseId goal = ClauseId_NULL) ;
+
+    static bool replay (cchar* filename, ProofTraverser& trav);   // Traverse a file written by 'Proof(filename)'. FALSE if it is not one;
+                                                                  // 'trav.done()' is called only if it is complete.
+};
+
+
+//=================================================================================================
+// ProofChecker -- verifies the resolution chains and the merges of a proof:
+
+
+// Every literal must be on a declared variable and every clause ID must be one seen so far;
+// otherwise the file is 'corrupt' and the rest of it is ignored. Clauses are kept until the proof
+// deletes them; a chain that resolves on a variable missing from either side, or uses a deleted
+// clause, is counted in 'bad'. Each checked clause is still recorded, so the IDs of the later ones
+// stay right, but only a clause whose whole derivation is valid is 'sound'.
+//
+// A query is proven if its clause is sound, holds no literal but '~act', and the only roots on
+// 'act' are clauses of the miter; 'a == b' then follows from the other roots. A merge needs a
+// proven query on the same pair in the same database, and the proof must end with 'done()'.
+// The roots themselves (the CNF of the circuit) are trusted, not re-derived.
+//
+class ProofChecker : public ProofTraverser {
+    vec<vec<Lit> >  clauses;
+    vec<char>       gone;           // 'gone[id]' is TRUE if clause 'id' was deleted.
+    vec<char>       sound;          // 'sound[id]' is TRUE if clause 'id' follows from the roots.
+    vec<vec<ClauseId> > occ;        // 'occ[x]': the first roots on variable 'x' (up to 3).
+    vec<Lit>        proven;         // Pairs 'a', 'b' of the proven queries.
+    vec<char>       mark;           // 'mark[index(p)]' is TRUE if 'p' is in the current resolvent.
+    vec<Lit>        resolvent;
+    int             n_vars;         // Variables declared to the current database.
+
+    bool    valid   (ClauseId id) const { return id >= 0 && id < clauses.size() && !gone[id]; }
+    bool    known   (ClauseId id) const { return id >= 0 && id < clauses.size(); }
+    bool    declared(Lit p)       const { return var(p) >= 0 && var(p) < n_vars; }
+    bool    check   (bool ok)           { if (!ok) corrupt = true; return ok && !corrupt; }
+    void    markLit (Lit p) { mark.growTo(index(p) + 2, 0); mark[index(p)] = 1; }
+    bool    marked  (Lit p) const { return index(p) < mark.size() && mark[index(p)]; }
+    bool    isMiter (ClauseId id, Lit p, Lit q, Lit r) const;
+
+public:
+    int         roots, chains, deletions, bad;
+    int         queries, merges, unproven;
+    bool        complete;           // TRUE if the proof ended properly.
+    bool        corrupt;            // TRUE if a record is out of range.
+    ClauseId    first_bad;          // ID of the first bad clause (ClauseId_NULL if none).
+    unsigned    first_x, first_y;   // Objects of the first unproven merge.
+
+    ProofChecker() : n_vars(0), roots(0), chains(0), deletions(0), bad(0), queries(0), merges(0), unproven(0),
+                     complete(false), corrupt(false), first_bad(ClauseId_NULL), first_x(0), first_y(0) {}
+
+    void    root    (const vec<Lit>& c, bool A);
+    void    chain   (const vec<ClauseId>& cs, const vec<Lit>& xs);
+    void    deleted (ClauseId c);
+    void    newSolver();
+    void    vars    (int n);
+    void    query   (ClauseId c, Lit act, Lit a, Lit b);
+    void    merge   (unsigned x, unsigned y, Lit a, Lit b);
+    void    done    () { complete = !corrupt; }
+
+    int     nClauses()                  const { return clauses.size(); }
+    const vec<Lit>& clause(ClauseId id) const { return clauses[id]; }
 };
 
 
@@ -26,16 +26,33 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 // Helper functions:
 
 
-void removeWatch(vec<Clause*>& ws, Clause* elem)
+void removeWatch(vec<Watcher>& ws, CRef elem)
 {
     if (ws.size() == 0) return;     // (skip lists that are already cleared)
     int j = 0;
-    for (; ws[j] != elem  ; j++) assert(j < ws.size());
+    for (; ws[j].cref != elem; j++) assert(j < ws.size());
     for (; j < ws.size()-1; j++) ws[j] = ws[j+1];
     ws.pop();
 }
 
 
+// The Luby sequence scaled by 'y': 1, 1, 2, 1, 1, 2, 4, 1, 1, 2, ... for y = 2 (x = 0, 1, 2, ...).
+//
+static double luby(double y, int x)
+{
+    // Find the finite subsequence that contains index 'x', and the size of that subsequence:
+    int size, seq;
+    for (size = 1, seq = 0; size < x+1; seq++, size = 2*size+1);
+
+    while (size-1 != x){
+        size = (size-1)>>1;
+        seq--;
+        x = x % size;
+    }
+    return pow(y, seq);
+}
+
+
 //=================================================================================================
 // Operations on clauses:
 
@@ -68,6 +85,8 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
     if (!learnt){
         assert(decisionLevel() == 0);
         ps_.copyTo(qs);                     // Make a copy of the input vector.
+        for (int i = 0; i < qs.size(); i++)
+            assert(!eliminated[var(qs[i])]);    // (freeze variables before 'preprocess()' if clauses on them come later)
 
         // Remove duplicates:
         sortUnique(qs);
@@ -82,7 +101,8 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
 
         // Remove false literals:
         int     i, j;
-        if (proof != NULL) proof->beginChain(proof->addRoot(qs,A));
+        if (proof != NULL) proof->vars(nVars()),
+                           proof->beginChain(proof->addRoot(qs,A));
         for (i = j = 0; i < qs.size(); i++)
             if (value(qs[i]) != l_False)
                 qs[j++] = qs[i];
@@ -105,7 +125,8 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
 
     }else{
         // Allocate clause:
-        Clause* c   = Clause_new(learnt, ps, id);
+        CRef    cr  = ca.alloc(learnt, ps, id);
+        Clause& c   = ca[cr];
 
         if (learnt){
             // Put the second watch on the literal with highest decision level:
@@ -115,47 +136,58 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
                 if (level[var(ps[i])] > max)
                     max   = level[var(ps[i])],
                     max_i = i;
-            (*c)[1]     = ps[max_i];
-            (*c)[max_i] = ps[1];
+            c[1]     = ps[max_i];
+            c[max_i] = ps[1];
 
             // Bumping:
             claBumpActivity(c); // (newly learnt clauses should be considered active)
 
             // Enqueue asserting literal:
-            check(enqueue((*c)[0], c));
+            check(enqueue(c[0], cr));
 
             // Store clause:
-            watches[index(~(*c)[0])].push(c);
-            watches[index(~(*c)[1])].push(c);
-            learnts.push(c);
-            stats.learnts_literals += c->size();
+            attach(cr);
+            learnts.push(cr);
+            stats.learnts_literals += c.size();
 
         }else{
             // Store clause:
-            watches[index(~(*c)[0])].push(c);
-            watches[index(~(*c)[1])].push(c);
-            clauses.push(c);
-            stats.clauses_literals += c->size();
+            attach(cr);
+            clauses.push(cr);
+            stats.clauses_literals += c.size();
         }
     }
 }
 
 
+// Puts the first two literals of a clause on watch. Binary clauses go to the implicit lists, where
+// each entry carries the other literal; longer clauses use the other watch as initial blocker.
+//
+void Solver::attach(CRef cr)
+{
+    const Clause& c = ca[cr];
+    vec<vec<Watcher> >& ws = c.size() == 2 ? watchesBin : watches;
+    ws[index(~c[0])].push(Watcher(cr, c[1]));
+    ws[index(~c[1])].push(Watcher(cr, c[0]));
+}
+
+
 // Disposes a clauses and removes it from watcher lists. NOTE! Low-level; does NOT change the 'clauses' and 'learnts' vector.
+// The memory is only reclaimed by the next 'garbageCollect()'.
 //
-void Solver::remove(Clause* c, bool just_dealloc)
+void Solver::remove(CRef cr)
 {
-    if (!just_dealloc){
-        removeWatch(watches[index(~(*c)[0])], c),
-        removeWatch(watches[index(~(*c)[1])], c);
+    Clause& c = ca[cr];
+    vec<vec<Watcher> >& ws = c.size() == 2 ? watchesBin : watches;
+    removeWatch(ws[index(~c[0])], cr),
+    removeWatch(ws[index(~c[1])], cr);
 
-        if (c->learnt()) stats.learnts_literals -= c->size();
-        else             stats.clauses_literals -= c->size();
+    if (c.learnt()) stats.learnts_literals -= c.size();
+    else            stats.clauses_literals -= c.size();
 
-        if (proof != NULL) proof->deleted(c->id());
-    }
+    if (proof != NULL) proof->deleted(c.id());
 
-    xfree(c);
+    ca.free(cr);
 }
 
 
@@ -163,11 +195,11 @@ void Solver::remove(Clause* c, bool just_dealloc)
 // the clause is binary and satisfied, in which case the first literal is true)
 // Returns True if clause is satisfied (will be removed), False otherwise.
 //
-bool Solver::simplify(Clause* c) const
+bool Solver::simplify(const Clause& c) const
 {
     assert(decisionLevel() == 0);
-    for (int i = 0; i < c->size(); i++){
-        if (value((*c)[i]) == l_True)
+    for (int i = 0; i < c.size(); i++){
+        if (value(c[i]) == l_True)
             return true;
     }
     return false;
@@ -186,13 +218,18 @@ Var Solver::newVar() {
     index = nVars();
     watches     .push();          // (list for positive literal)
     watches     .push();          // (list for negative literal)
-    reason      .push(NULL);
+    watchesBin  .push();
+    watchesBin  .push();
+    reason      .push(CRef_Undef);
     assigns     .push(toInt(l_Undef));
     level       .push(-1);
     trail_pos   .push(-1);
     activity    .push(0);
     order       .newVar();
     analyze_seen.push(0);
+    polarity    .push(1);
+    frozen      .push(0);
+    eliminated  .push(0);
     if (proof != NULL) unit_id.push(ClauseId_NULL);
     return index; }
 
@@ -208,8 +245,9 @@ void Solver::cancelUntil(int level) {
     if (decisionLevel() > level){
         for (int c = trail.size()-1; c >= trail_lim[level]; c--){
             Var     x  = var(trail[c]);
-            assigns[x] = toInt(l_Undef);
-            reason [x] = NULL;
+            assigns [x] = toInt(l_Undef);
+            reason  [x] = CRef_Undef;
+            if (phase_saving) polarity[x] = sign(trail[c]);
             order.undo(x); }
         trail.shrink(trail.size() - trail_lim[level]);
         trail_lim.shrink(trail_lim.size() - level);
@@ -222,7 +260,7 @@ void Solver::cancelUntil(int level) {
 
 /*_________________________________________________________________________________________________
 |
-|  analyze : (confl : Clause*) (out_learnt : vec<Lit>&) (out_btlevel : int&)  ->  [void]
+|  analyze : (confl : CRef) (out_learnt : vec<Lit>&) (out_btlevel : int&)  ->  [void]
 |  
 |  Description:
 |    Analyze conflict and produce a reason clause ('out_learnt') and a backtracking level
@@ -243,7 +281,7 @@ public:
     lastToFirst_lt(const vec<int>& t) : trail_pos(t) {}
     bool operator () (Lit p, Lit q) { return trail_pos[var(p)] > trail_pos[var(q)]; }
 };
-void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
+void Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel)
 {
     vec<char>&     seen  = analyze_seen;
     int            pathC = 0;
@@ -251,16 +289,24 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 
     // Generate conflict clause:
     //
-    if (proof != NULL) proof->beginChain(confl->id());
+    if (proof != NULL) proof->beginChain(ca[confl].id());
     out_learnt.push();          // (leave room for the asserting literal)
     out_btlevel = 0;
     int index = trail.size()-1;
     for(;;){
-        assert(confl != NULL);  // (otherwise should be UIP)
-
-        Clause& c = *confl;
-        if (c.learnt())
-            claBumpActivity(&c);
+        assert(confl != CRef_Undef);  // (otherwise should be UIP)
+
+        Clause& c = (p == lit_Undef) ? ca[confl] : reasonOf(var(p));
+        if (c.learnt()){
+            claBumpActivity(c);
+            if (lbd_tiers){
+                // Mark the clause as useful and tighten its LBD under the current assignment:
+                c.setUsed(true);
+                if (c.lbd() > lbd_core){
+                    int lbd = computeLbd(c);
+                    if (lbd < c.lbd()) c.setLbd(lbd); }
+            }
+        }
 
         for (int j = (p == lit_Undef) ? 0 : 1; j < c.size(); j++){
             Lit q = c[j];
@@ -287,7 +333,7 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
         pathC--;
         if (pathC == 0) break;
 
-        if (proof != NULL) proof->resolve(confl->id(), ~p);
+        if (proof != NULL) proof->resolve(ca[confl].id(), ~p);
     }
     out_learnt[0] = ~p;
 
@@ -303,18 +349,18 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 
         analyze_toclear.clear();
         for (i = j = 1; i < out_learnt.size(); i++)
-            if (reason[var(out_learnt[i])] == NULL || !analyze_removable(out_learnt[i], min_level))
+            if (reason[var(out_learnt[i])] == CRef_Undef || !analyze_removable(out_learnt[i], min_level))
                 out_learnt[j++] = out_learnt[i];
     }else if(expensive_ccmin == 1){
         // Simplify conflict clause (a little):
         //
         analyze_toclear.clear();
         for (i = j = 1; i < out_learnt.size(); i++){
-            Clause* r = reason[var(out_learnt[i])];
-            if (r == NULL)
+            CRef r = reason[var(out_learnt[i])];
+            if (r == CRef_Undef)
                 out_learnt[j++] = out_learnt[i];
             else{
-                Clause& c = *r;
+                Clause& c = reasonOf(var(out_learnt[i]));
                 for (int k = 1; k < c.size(); k++)
                     if (!seen[var(c[k])] && level[var(c[k])] != 0){
                         out_learnt[j++] = out_learnt[i];
@@ -333,7 +379,7 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
         for (int k = 0; k < analyze_toclear.size(); k++){
             Var     v = var(analyze_toclear[k]); assert(level[v] > 0);
 				Lit     l = analyze_toclear[k];
-            Clause& c = *reason[v];
+            Clause& c = reasonOf(v);
             proof->resolve(c.id(), l);
             for (int k = 1; k < c.size(); k++)
                 if (level[var(c[k])] == 0)
@@ -356,17 +402,17 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 //
 bool Solver::analyze_removable(Lit p, uint min_level)
 {
-    assert(reason[var(p)] != NULL);
+    assert(reason[var(p)] != CRef_Undef);
     analyze_stack.clear(); analyze_stack.push(p);
     int top = analyze_toclear.size();
     while (analyze_stack.size() > 0){
-        assert(reason[var(analyze_stack.last())] != NULL);
-        Clause& c = *reason[var(analyze_stack.last())];
+        assert(reason[var(analyze_stack.last())] != CRef_Undef);
+        Clause& c = reasonOf(var(analyze_stack.last()));
         analyze_stack.pop();
         for (int i = 1; i < c.size(); i++){
             Lit p = c[i];
             if (!analyze_seen[var(p)] && level[var(p)] != 0){
-                if (reason[var(p)] != NULL && ((1 << (level[var(p)] & 31)) & min_level) != 0){
+                if (reason[var(p)] != CRef_Undef && ((1 << (level[var(p)] & 31)) & min_level) != 0){
                     analyze_seen[var(p)] = 1;
                     analyze_stack.push(p);
                     analyze_toclear.push(p);
@@ -387,7 +433,7 @@ bool Solver::analyze_removable(Lit p, uint min_level)
 
 /*_________________________________________________________________________________________________
 |
-|  analyzeFinal : (confl : Clause*) (skip_first : bool)  ->  [void]
+|  analyzeFinal : (confl : CRef) (skip_first : bool)  ->  [void]
 |  
 |  Description:
 |    Specialized analysis procedure to express the final conflict in terms of assumptions.
@@ -395,7 +441,7 @@ bool Solver::analyze_removable(Lit p, uint min_level)
 |    making assumptions). If 'skip_first' is TRUE, the first literal of 'confl' is  ignored (needed
 |    if conflict arose before search even started).
 |________________________________________________________________________________________________@*/
-void Solver::analyzeFinal(Clause* confl, bool skip_first)
+void Solver::analyzeFinal(CRef cr, bool skip_first)
 {
     // -- NOTE! This code is relatively untested. Please report bugs!
     conflict.clear();
@@ -404,10 +450,11 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
         return; }
    //assert(false);
     vec<char>&     seen  = analyze_seen;
-    if (proof != NULL) proof->beginChain(confl->id());
-    for (int i = skip_first ? 1 : 0; i < confl->size(); i++){
-        Var     x = var((*confl)[i]);
-		  Lit		 l = (*confl)[i];
+    Clause&        confl = ca[cr];
+    if (proof != NULL) proof->beginChain(confl.id());
+    for (int i = skip_first ? 1 : 0; i < confl.size(); i++){
+        Var     x = var(confl[i]);
+		  Lit		 l = confl[i];
         if (level[x] > 0)
             seen[x] = 1;
         else
@@ -419,12 +466,12 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
         Var     x = var(trail[i]);
 		  Lit     l = trail[i];
         if (seen[x]){
-            Clause* r = reason[x];
-            if (r == NULL){
+            CRef r = reason[x];
+            if (r == CRef_Undef){
                 assert(level[x] > 0);
                 conflict.push(~trail[i]);
             }else{
-                Clause& c = *r;
+                Clause& c = reasonOf(x);
                 if (proof != NULL) proof->resolve(c.id(), l);
                 for (int j = 1; j < c.size(); j++)
                     if (level[var(c[j])] > 0)
@@ -441,7 +488,7 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
 
 /*_________________________________________________________________________________________________
 |
-|  enqueue : (p : Lit) (from : Clause*)  ->  [bool]
+|  enqueue : (p : Lit) (from : CRef)  ->  [bool]
 |  
 |  Description:
 |    Puts a new fact on the propagation queue as well as immediately updating the variable's value.
@@ -450,12 +497,12 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
 |  Input:
 |    p    - The fact to enqueue
 |    from - [Optional] Fact propagated from this (currently) unit clause. Stored in 'reason[]'.
-|           Default value is NULL (no reason).
+|           Default value is CRef_Undef (no reason).
 |  
 |  Output:
 |    TRUE if fact was enqueued without conflict, FALSE otherwise.
 |________________________________________________________________________________________________@*/
-bool Solver::enqueue(Lit p, Clause* from)
+bool Solver::enqueue(Lit p, CRef from)
 {
     if (value(p) != l_Undef)
         return value(p) != l_False;
@@ -471,74 +518,147 @@ bool Solver::enqueue(Lit p, Clause* from)
 }
 
 
+// Returns the reason clause of the assigned variable 'x' with the implied literal in 'c[0]'. Binary
+// clauses are propagated from 'watchesBin' without being touched, so their literals are put in
+// order here, when (and if) conflict analysis actually needs them.
+//
+Clause& Solver::reasonOf(Var x)
+{
+    Clause& c = ca[reason[x]];
+    if (c.size() == 2 && var(c[0]) != x){
+        Lit tmp = c[0]; c[0] = c[1]; c[1] = tmp; }
+    assert(var(c[0]) == x);
+    return c;
+}
+
+
+// Literal block distance: the number of distinct decision levels among the literals of 'c'.
+//
+template<class C>
+int Solver::computeLbd(const C& c)
+{
+    if (level_stamp.size() <= decisionLevel())
+        level_stamp.growTo(decisionLevel() + 1, 0);
+    if (++lbd_stamp == 0){     // (wrapped around -- forget all old stamps)
+        for (int i = 0; i < level_stamp.size(); i++) level_stamp[i] = 0;
+        lbd_stamp = 1; }
+    int lbd = 0;
+    for (int i = 0; i < c.size(); i++){
+        int l = level[var(c[i])];
+        if (level_stamp[l] != lbd_stamp){
+            level_stamp[l] = lbd_stamp;
+            lbd++; }
+    }
+    return lbd;
+}
+
+
+// Record the LBD of a new learnt clause in the averages used by glucose restarts.
+//
+void Solver::pushLbd(int lbd)
+{
+    lbd_total_sum += lbd;
+    lbd_total_cnt++;
+    if (lbd_recent.size() < lbd_window){
+        lbd_recent.push(lbd);
+        lbd_recent_sum += lbd;
+    }else{
+        lbd_recent_sum += lbd - lbd_recent[lbd_recent_pos];
+        lbd_recent[lbd_recent_pos] = lbd;
+        lbd_recent_pos = (lbd_recent_pos + 1) % lbd_window;
+    }
+}
+
+
+// Should 'search()' give up the current branch? Geometric and Luby restarts simply count conflicts;
+// glucose restarts as soon as the recent learnts are clearly worse (higher LBD) than the average.
+//
+bool Solver::restartDue(int conflictC, int nof_conflicts, const SearchParams& params) const
+{
+    if (params.restarts != restart_glucose)
+        return nof_conflicts >= 0 && conflictC >= nof_conflicts;
+    return lbd_recent.size() == lbd_window
+        && (double)lbd_recent_sum / lbd_window * lbd_K > (double)lbd_total_sum / lbd_total_cnt;
+}
+
+
 
 /*_________________________________________________________________________________________________
 |
-|  propagate : [void]  ->  [Clause*]
+|  propagate : [void]  ->  [CRef]
 |  
 |  Description:
 |    Propagates all enqueued facts. If a conflict arises, the conflicting clause is returned,
-|    otherwise NULL. NOTE! This method has been optimized for speed rather than readability.
+|    otherwise CRef_Undef. NOTE! This method has been optimized for speed rather than readability.
 |  
 |    Post-conditions:
 |      * The propagation queue is empty, even if there was a conflict.
 |________________________________________________________________________________________________@*/
-Clause* Solver::propagate()
+CRef Solver::propagate()
 {
-    Clause* confl = NULL;
+    CRef    confl = CRef_Undef;
     while (qhead < trail.size()){
         stats.propagations++;
         simpDB_props--;
 
         Lit            p  = trail[qhead++];     // 'p' is enqueued fact to propagate.
-        vec<Clause*>&  ws = watches[index(p)];
-        Clause**       i,** j,** end;
+        Lit            false_lit = ~p;
+
+        // Binary clauses first -- the implied literal is in the watch itself:
+        vec<Watcher>&  wbin = watchesBin[index(p)];
+        for (int k = 0; k < wbin.size(); k++){
+            Lit imp = wbin[k].blocker;
+            if (value(imp) == l_True) continue;
+            if (decisionLevel() == 0 && proof != NULL)
+                logUnit(wbin[k].cref, imp);
+            if (!enqueue(imp, wbin[k].cref)){
+                if (decisionLevel() == 0)
+                    ok = false;
+                confl = wbin[k].cref;
+                qhead = trail.size();
+                goto Conflict; }
+        }
+
+        {
+        vec<Watcher>&  ws = watches[index(p)];
+        Watcher        *i, *j, *end;
+
+        for (i = j = (Watcher*)ws, end = i + ws.size();  i != end;){
+            // Skip the clause without looking at it if the blocker is true:
+            if (value(i->blocker) == l_True){
+                *j++ = *i++; continue; }
 
-        for (i = j = (Clause**)ws, end = i + ws.size();  i != end;){
-            Clause& c = **i; i++;
+            CRef    cr = i->cref;
+            Clause& c  = ca[cr];
+            i++;
             // Make sure the false literal is data[1]:
-            Lit false_lit = ~p;
             if (c[0] == false_lit)
                 c[0] = c[1], c[1] = false_lit;
 
             assert(c[1] == false_lit);
 
-            // If 0th watch is true, then clause is already satisfied.
-            Lit   first = c[0];
-            lbool val   = value(first);
-            if (val == l_True){
-                *j++ = &c;
+            // If 0th watch is true, then clause is already satisfied (and 'c[0]' becomes the blocker).
+            Lit     first = c[0];
+            Watcher w(cr, first);
+            if (value(first) == l_True){
+                *j++ = w;
             }else{
                 // Look for new watch:
                 for (int k = 2; k < c.size(); k++)
                     if (value(c[k]) != l_False){
                         c[1] = c[k]; c[k] = false_lit;
-                        watches[index(~c[1])].push(&c);
+                        watches[index(~c[1])].push(w);
                         goto FoundWatch; }
 
                 // Did not find watch -- clause is unit under assignment:
-                if (decisionLevel() == 0 && proof != NULL){
-                    // Log the production of this unit clause:
-                    proof->beginChain(c.id());
-                    for (int k = 1; k < c.size(); k++)
-                        proof->resolve(unit_id[var(c[k])], c[k]);
-                    ClauseId id = proof->endChain();
-                    assert(unit_id[var(first)] == ClauseId_NULL || value(first) == l_False);    // (if variable already has 'id', it must be with the other polarity and we should have derived the empty clause here)
-                    if (value(first) != l_False)
-                        unit_id[var(first)] = id;
-                    else{
-                        // Empty clause derived:
-                        proof->beginChain(unit_id[var(first)]);
-                        proof->resolve(id, ~first);
-                        proof->endChain();
-                    }
-                }
-					 
-                *j++ = &c;
-                if (!enqueue(first, &c)){
+                if (decisionLevel() == 0 && proof != NULL)
+                    logUnit(cr, first);
+
+                *j++ = w;
+                if (!enqueue(first, cr)){
                     if (decisionLevel() == 0)
                         ok = false;
-                    confl = &c;
+                    confl = cr;
                     qhead = trail.size();
                     // Copy the remaining watches:
                     while (i < end)
@@ -548,12 +668,36 @@ Clause* Solver::propagate()
             }
         }
         ws.shrink(i - j);
+        }
+      Conflict:;
     }
 
     return confl;
 }
 
 
+// Log the production of the top-level unit 'first' by clause 'cr' (all its other literals are false):
+//
+void Solver::logUnit(CRef cr, Lit first)
+{
+    Clause& c = ca[cr];
+    proof->beginChain(c.id());
+    for (int k = 0; k < c.size(); k++)
+        if (c[k] != first)
+            proof->resolve(unit_id[var(c[k])], c[k]);
+    ClauseId id = proof->endChain();
+    assert(unit_id[var(first)] == ClauseId_NULL || value(first) == l_False);    // (if variable already has 'id', it must be with the other polarity and we should have derived the empty clause here)
+    if (value(first) != l_False)
+        unit_id[var(first)] = id;
+    else{
+        // Empty clause derived:
+        proof->beginChain(unit_id[var(first)]);
+        proof->resolve(id, ~first);
+        proof->endChain();
+    }
+}
+
+
 /*_________________________________________________________________________________________________
 |
 |  reduceDB : ()  ->  [void]
@@ -561,27 +705,105 @@ Clause* Solver::propagate()
 |  Description:
 |    Remove half of the learnt clauses, minus the clauses locked by the current assignment. Locked
 |    clauses are clauses that are reason to some assignment. Binary clauses are never removed.
+|    The clause region is compacted afterwards if enough of it has become garbage.
 |________________________________________________________________________________________________@*/
-struct reduceDB_lt { bool operator () (Clause* x, Clause* y) { return x->size() > 2 && (y->size() == 2 || x->activity() < y->activity()); } };
+struct reduceDB_lt {
+    ClauseAllocator& ca;
+    reduceDB_lt(ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) { return ca[x].size() > 2 && (ca[y].size() == 2 || ca[x].activity() < ca[y].activity()); } };
 void Solver::reduceDB()
 {
     int     i, j;
     double  extra_lim = cla_inc / learnts.size();    // Remove any clause below this activity
 
-    sort(learnts, reduceDB_lt());
+    sort(learnts, reduceDB_lt(ca));
     for (i = j = 0; i < learnts.size() / 2; i++){
-        if (learnts[i]->size() > 2 && !locked(learnts[i]))
+        if (ca[learnts[i]].size() > 2 && !locked(learnts[i]))
             remove(learnts[i]);
         else
             learnts[j++] = learnts[i];
     }
     for (; i < learnts.size(); i++){
-        if (learnts[i]->size() > 2 && !locked(learnts[i]) && learnts[i]->activity() < extra_lim)
+        if (ca[learnts[i]].size() > 2 && !locked(learnts[i]) && ca[learnts[i]].activity() < extra_lim)
             remove(learnts[i]);
         else
             learnts[j++] = learnts[i];
     }
     learnts.shrink(i - j);
+    checkGarbage();
+}
+
+
+// Tiered variant of 'reduceDB()' (used with 'SearchParams::lbd_tiers'), run on a conflict schedule:
+// learnts with LBD up to 'lbd_core' are kept for good, those up to 'lbd_tier2' as long as they
+// were used in conflict analysis since the last run. The rest form the local tier, whose less
+// active half is removed.
+//
+struct reduceDBTiers_lt {
+    ClauseAllocator& ca;
+    reduceDBTiers_lt(ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) { return ca[x].lbd() > ca[y].lbd() || (ca[x].lbd() == ca[y].lbd() && ca[x].activity() < ca[y].activity()); } };
+void Solver::reduceDBTiers()
+{
+    vec<CRef>   local;
+    int         i, j;
+    for (i = j = 0; i < learnts.size(); i++){
+        Clause& c = ca[learnts[i]];
+        if (c.size() == 2 || c.lbd() <= lbd_core || (c.lbd() <= lbd_tier2 && c.used()))
+            learnts[j++] = learnts[i];
+        else
+            local.push(learnts[i]);
+        c.setUsed(false);
+    }
+    learnts.shrink(i - j);
+
+    sort(local, reduceDBTiers_lt(ca));
+    for (i = 0; i < local.size(); i++){
+        if (i < local.size() / 2 && !locked(local[i]))
+            remove(local[i]);
+        else
+            learnts.push(local[i]);
+    }
+    next_reduce = stats.conflicts + 2000 + 300 * (++reduce_rounds);
+    checkGarbage();
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  garbageCollect : [void]  ->  [void]
+|  
+|  Description:
+|    Copy every live clause into a fresh region, in watch-list order, and rewrite all references
+|    (watches, reasons, clause lists) to the new offsets.
+|________________________________________________________________________________________________@*/
+void Solver::relocAll(ClauseAllocator& to)
+{
+    // All watchers:
+    for (int i = 0; i < watches.size(); i++){
+        for (int j = 0; j < watchesBin[i].size(); j++)
+            ca.reloc(watchesBin[i][j].cref, to);
+        for (int j = 0; j < watches[i].size(); j++)
+            ca.reloc(watches[i][j].cref, to);
+    }
+
+    // All reasons (a reason clause is locked, hence still alive):
+    for (int i = 0; i < trail.size(); i++){
+        Var v = var(trail[i]);
+        if (reason[v] != CRef_Undef)
+            ca.reloc(reason[v], to);
+    }
+
+    // All clauses:
+    for (int i = 0; i < learnts.size(); i++) ca.reloc(learnts[i], to);
+    for (int i = 0; i < clauses.size(); i++) ca.reloc(clauses[i], to);
+}
+
+void Solver::garbageCollect()
+{
+    ClauseAllocator to(ca.size() - ca.wasted());
+    relocAll(to);
+    ca.moveFrom(to);
 }
 
 
@@ -598,7 +820,7 @@ void Solver::simplifyDB()
     if (!ok) return;    // GUARD (public method)
     assert(decisionLevel() == 0);
 
-    if (propagate() != NULL){
+    if (propagate() != CRef_Undef){
         ok = false;
         return; }
 
@@ -610,20 +832,23 @@ void Solver::simplifyDB()
         Lit p = trail[i];
         watches[index( p)].clear(true);
         watches[index(~p)].clear(true);
+        watchesBin[index( p)].clear(true);
+        watchesBin[index(~p)].clear(true);
     }
 
     // Remove satisfied clauses:
     for (int type = 0; type < 2; type++){
-        vec<Clause*>& cs = type ? learnts : clauses;
+        vec<CRef>&    cs = type ? learnts : clauses;
         int           j  = 0;
         for (int i = 0; i < cs.size(); i++){
-            if (!locked(cs[i]) && simplify(cs[i]))
+            if (!locked(cs[i]) && simplify(ca[cs[i]]))
                 remove(cs[i]);
             else
                 cs[j++] = cs[i];
         }
         cs.shrink(cs.size()-j);
     }
+    checkGarbage();
 
     simpDB_assigns = nAssigns();
     simpDB_props   = stats.clauses_literals + stats.learnts_literals;   // (shouldn't depend on 'stats' really, but it will do for now)
@@ -653,11 +878,13 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
     int     conflictC = 0;
     var_decay = 1 / params.var_decay;
     cla_decay = 1 / params.clause_decay;
+    phase_saving = params.phase_saving;
+    lbd_tiers    = params.lbd_tiers;
     model.clear();
 
     for (;;){
-        Clause* confl = propagate();
-        if (confl != NULL){
+        CRef confl = propagate();
+        if (confl != CRef_Undef){
             // CONFLICT
 
             stats.conflicts++; conflictC++;
@@ -668,8 +895,13 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
                 analyzeFinal(confl);
                 return l_False; }
             analyze(confl, learnt_clause, backtrack_level);
+            int lbd = 0;
+            if (lbd_tiers || params.restarts == restart_glucose){
+                lbd = computeLbd(learnt_clause);
+                pushLbd(lbd); }
             cancelUntil(max(backtrack_level, root_level));
             newClause(learnt_clause, true, (proof != NULL) ? proof->last() : ClauseId_NULL);
+            if (learnt_clause.size() > 1) ca[learnts.last()].setLbd(lbd);
             if (learnt_clause.size() == 1) level[var(learnt_clause[0])] = 0;    // (this is ugly (but needed for 'analyzeFinal()') -- in future versions, we will backtrack past the 'root_level' and redo the assumptions)
             varDecayActivity();
             claDecayActivity();
@@ -677,23 +909,28 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
         }else{
             // NO CONFLICT
 
-            if (nof_conflicts >= 0 && conflictC >= nof_conflicts){
-                // Reached bound on number of conflicts:
+            if (restartDue(conflictC, nof_conflicts, params) || budgetOut()){
+                // Reached bound on number of conflicts (or glucose asks for a restart, or the budget is spent):
                 progress_estimate = progressEstimate();
                 cancelUntil(root_level);
+                if (params.restarts == restart_glucose){
+                    lbd_recent.clear(); lbd_recent_pos = 0; lbd_recent_sum = 0; }
                 return l_Undef; }
 
             if (decisionLevel() == 0)
                 // Simplify the set of problem clauses:
                 simplifyDB(), assert(ok);
 
-            if (nof_learnts >= 0 && learnts.size()-nAssigns() >= nof_learnts)
+            if (lbd_tiers ? stats.conflicts >= next_reduce : (nof_learnts >= 0 && learnts.size()-nAssigns() >= nof_learnts)){
                 // Reduce the set of learnt clauses:
-                reduceDB();
+                if (lbd_tiers) reduceDBTiers();
+                else           reduceDB(); }
 
             // New variable decision:
             stats.decisions++;
             Var next = order.select(params.random_var_freq);
+            while (next != var_Undef && eliminated[next])     // (eliminated variables are left to 'extendModel()')
+                next = order.select(params.random_var_freq);
 
             if (next == var_Undef){
                 // Model found:
@@ -703,7 +940,7 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
                 return l_True;
             }
 
-            check(assume(~Lit(next)));
+            check(assume(Lit(next, polarity[next])));
         }
     }
 }
@@ -737,7 +974,7 @@ void Solver::varRescaleActivity()
 void Solver::claRescaleActivity()
 {
     for (int i = 0; i < learnts.size(); i++)
-        learnts[i]->activity() *= 1e-20;
+        ca[learnts[i]].activity() *= 1e-20;
     cla_inc *= 1e-20;
 }
 
@@ -755,15 +992,17 @@ void Solver::claRescaleActivity()
 |    A list of assumptions (unit clauses coded as literals). Pre-condition: The assumptions must
 |    not contain both 'x' and '~x' for any variable 'x'.
 |________________________________________________________________________________________________@*/
-bool Solver::solve(const vec<Lit>& assumps)
+lbool Solver::solveLimited(const vec<Lit>& assumps)
 {
     simplifyDB();
-    if (!ok) return false;
+    if (!ok) return l_False;
 
     SearchParams    params(default_params);
     double  nof_conflicts = 100;
     double  nof_learnts   = nClauses() / 3;
     lbool   status        = l_Undef;
+    int     curr_restarts = 0;
+    double  adjust_confl  = stats.conflicts + 100, adjust_inc = 100;
 
     // Perform assumptions:
     root_level = assumps.size();
@@ -771,7 +1010,8 @@ bool Solver::solve(const vec<Lit>& assumps)
         Lit p = assumps[i];
         assert(var(p) < nVars());
         if (!assume(p)){
-            if (reason[var(p)] != NULL){
+            if (reason[var(p)] != CRef_Undef){
+                reasonOf(var(p));               // (orders a binary reason so that 'skip_first' skips '~p')
                 analyzeFinal(reason[var(p)], true);
                 conflict.push(~p);
             }else{
@@ -781,12 +1021,12 @@ bool Solver::solve(const vec<Lit>& assumps)
                 if (proof != NULL) conflict_id = unit_id[var(p)];
             }
             cancelUntil(0);
-            return false; }
-        Clause* confl = propagate();
-        if (confl != NULL){
+            return l_False; }
+        CRef confl = propagate();
+        if (confl != CRef_Undef){
             analyzeFinal(confl), assert(conflict.size() > 0);
             cancelUntil(0);
-            return false; }
+            return l_False; }
     }
     assert(root_level == decisionLevel());
 
@@ -802,7 +1042,8 @@ bool Solver::solve(const vec<Lit>& assumps)
         reportf("===================================\n");
     }
 
-    while (status == l_Undef){
+    budget_end = conflict_budget < 0 ? -1 : stats.conflicts + conflict_budget;
+    while (status == l_Undef && !budgetOut()){
         if (verbosity >= 1){
             printStats();
             reportf("| %9d | %7d %8d | %7d %7d %8d %7.1f | %6.3f %% |\n",
@@ -814,9 +1055,19 @@ bool Solver::solve(const vec<Lit>& assumps)
                    progress_estimate*100);
             fflush(stdout);
         }
+        if      (params.restarts == restart_luby)    nof_conflicts = luby(2, curr_restarts) * luby_unit;
+        else if (params.restarts == restart_glucose) nof_conflicts = -1;
         status = search((int)nof_conflicts, (int)nof_learnts, params);
-        nof_conflicts *= 1.5;
-        nof_learnts   *= 1.1;
+        curr_restarts++;
+        if (params.restarts == restart_geometric){
+            nof_conflicts *= 1.5;
+            nof_learnts   *= 1.1;
+        }else
+            // (restarts are frequent here, so grow the learnt limit with the conflicts instead)
+            while (stats.conflicts >= adjust_confl){
+                nof_learnts  *= 1.1;
+                adjust_inc   *= 1.5;
+                adjust_confl += adjust_inc; }
     }
     if (verbosity >= 1) {
         reportf("===========================================");
@@ -824,7 +1075,9 @@ bool Solver::solve(const vec<Lit>& assumps)
     }
 
     cancelUntil(0);
-    return status == l_True;
+    if (status == l_True && elimclauses.size() > 0)
+        extendModel();
+    return status;
 }
 
 void Solver::printStats()
@@ -40,9 +40,15 @@ struct SolverStats {
 };
 
 
+enum RestartMode { restart_geometric, restart_luby, restart_glucose };
+
 struct SearchParams {
     double  var_decay, clause_decay, random_var_freq;    // (reasonable values are: 0.95, 0.999, 0.02)    
-    SearchParams(double v = 1, double c = 1, double r = 0) : var_decay(v), clause_decay(c), random_var_freq(r) { }
+    int     restarts;           // restart_geometric (x1.5 per restart), restart_luby or restart_glucose (recent vs. overall LBD)
+    bool    phase_saving;       // Branch on the last value a variable had instead of its fixed sign (FALSE unless hinted).
+    bool    lbd_tiers;          // Keep learnts by literal block distance (core / tier2 / local) instead of by activity only.
+    SearchParams(double v = 1, double c = 1, double r = 0) : var_decay(v), clause_decay(c), random_var_freq(r)
+      , restarts(restart_geometric), phase_saving(false), lbd_tiers(false) { }
 };
 
 
@@ -51,8 +57,9 @@ protected:
     // Solver state:
     //
     bool                ok;               // If FALSE, the constraints are already unsatisfiable. No part of the solver state may be used!
-    vec<Clause*>        clauses;          // List of problem clauses.
-    vec<Clause*>        learnts;          // List of learnt clauses.
+    ClauseAllocator     ca;               // Region holding every clause; the lists below store offsets into it.
+    vec<CRef>           clauses;          // List of problem clauses.
+    vec<CRef>           learnts;          // List of learnt clauses.
     vec<ClauseId>       unit_id;          // 'unit_id[var]' is the clause ID for the unit literal 'var' or '~var' (if set at toplevel).
     double              cla_inc;          // Amount to bump next clause with.
     double              cla_decay;        // INVERSE decay factor for clause activity: stores 1/decay.
@@ -62,11 +69,12 @@ protected:
     double              var_decay;        // INVERSE decay factor for variable activity: stores 1/decay. Use negative value for static variable order.
     VarOrder            order;            // Keeps track of the decision variable order.
 
-    vec<vec<Clause*> >  watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    vec<vec<Watcher> >  watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    vec<vec<Watcher> >  watchesBin;       // 'watchesBin[lit]' is the same for binary clauses; 'blocker' holds the implied literal.
     vec<char>           assigns;          // The current assignments (lbool:s stored as char:s).
     vec<Lit>            trail;            // Assignment stack; stores all assigments made in the order they were made.
     vec<int>            trail_lim;        // Separator indices for different decision levels in 'trail[]'.
-    vec<Clause*>        reason;           // 'reason[var]' is the clause that implied the variables current value, or 'NULL' if none.
+    vec<CRef>           reason;           // 'reason[var]' is the clause that implied the variables current value, or 'CRef_Undef' if none.
     vec<int>            level;            // 'level[var]' is the decision level at which assignment was made.
     vec<int>            trail_pos;        // 'trail_pos[var]' is the variable's position in 'trail[]'. This supersedes 'level[]' in some sense, and 'level[]' will probably be removed in future releases.
     int                 root_level;       // Level of first proper decision.
@@ -74,13 +82,34 @@ protected:
     int                 simpDB_assigns;   // Number of top-level assignments since last execution of 'simplifyDB()'.
     int64               simpDB_props;     // Remaining number of propagations that must be made before next execution of 'simplifyDB()'.
 
+    vec<char>           polarity;         // The sign each variable is decided with: a hint from 'setPolarity()', or its last value when saving phases.
+    bool                phase_saving;     // }- Copied from the 'SearchParams' of the current search.
+    bool                lbd_tiers;        // }
+    int64               next_reduce;      // (LBD tiers only) Conflict count at which 'reduceDB()' runs next.
+    int64               budget_end;       // Conflict count at which 'solveLimited()' gives up (-1 = never).
+    int                 reduce_rounds;    // (LBD tiers only) Number of 'reduceDB()' runs so far.
+    vec<uint>           level_stamp;      // 'level_stamp[level]' marks levels already counted by 'computeLbd()'.
+    uint                lbd_stamp;
+    vec<int>            lbd_recent;       // (glucose restarts) Ring of the LBDs of the last 'lbd_window' learnts.
+    int                 lbd_recent_pos;
+    int64               lbd_recent_sum;
+    int64               lbd_total_sum;    // Sum and count of the LBDs of all learnts so far.
+    int64               lbd_total_cnt;
+
+    // Preprocessing state (see 'Preprocess.cpp'):
+    //
+    vec<char>           frozen;           // 'frozen[var]' is TRUE if 'var' must survive preprocessing (assumptions, later clauses, model reads).
+    vec<char>           eliminated;       // 'eliminated[var]' is TRUE if 'var' was removed by variable elimination.
+    vec<uint>           elimclauses;      // Clauses of eliminated variables for 'extendModel()': literals (the eliminated one first), then the size.
+    vec<vec<CRef> >     occurs;           // (during 'preprocess()' only) 'occurs[var]' lists the problem clauses containing 'var' (may hold removed ones).
+    vec<int>            n_occ;            // (during 'preprocess()' only) 'n_occ[lit]' is the number of problem clauses containing 'lit'.
+    vec<CRef>           subsumption_queue;
+
     // Temporaries (to reduce allocation overhead). Each variable is prefixed by the method in which is used:
     //
     vec<char>           analyze_seen;
     vec<Lit>            analyze_stack;
     vec<Lit>            analyze_toclear;
-    Clause*             propagate_tmpbin;
-    Clause*             analyze_tmpbin;
     vec<Lit>            addUnit_tmp;
     vec<Lit>            addBinary_tmp;
     vec<Lit>            addTernary_tmp;
@@ -91,16 +120,38 @@ protected:
     void        cancelUntil      (int level);
     void        record           (const vec<Lit>& clause);
 
-    void        analyze          (Clause* confl, vec<Lit>& out_learnt, int& out_btlevel); // (bt = backtrack)
+    void        analyze          (CRef confl, vec<Lit>& out_learnt, int& out_btlevel);    // (bt = backtrack)
     bool        analyze_removable(Lit p, uint min_level);                                 // (helper method for 'analyze()')
-    void        analyzeFinal     (Clause* confl, bool skip_first = false);
-    bool        enqueue          (Lit fact, Clause* from = NULL);
-    Clause*     propagate        ();
+    void        analyzeFinal     (CRef confl, bool skip_first = false);
+    bool        enqueue          (Lit fact, CRef from = CRef_Undef);
+    Clause&     reasonOf         (Var x);
+    template<class C>
+    int         computeLbd       (const C& c);
+    void        pushLbd          (int lbd);
+    bool        restartDue       (int conflictC, int nof_conflicts, const SearchParams& params) const;
+    bool        budgetOut        () const { return (budget_end >= 0 && stats.conflicts >= budget_end) || (interrupt != NULL && *interrupt); }
+    CRef        propagate        ();
+    void        logUnit          (CRef cr, Lit first);
     void        reduceDB         ();
+    void        reduceDBTiers    ();
+    void        relocAll         (ClauseAllocator& to);
+    void        garbageCollect   ();
+    void        checkGarbage     () { if (ca.wasted() > ca.size() * garbage_frac) garbageCollect(); }
     Lit         pickBranchLit    (const SearchParams& params);
     lbool       search           (int nof_conflicts, int nof_learnts, const SearchParams& params);
     double      progressEstimate ();
 
+    // Preprocessing:
+    //
+    bool        addClauseOcc     (const vec<Lit>& ps);
+    void        removeClauseOcc  (CRef cr);
+    Lit         subsumes         (const Clause& c, const Clause& d) const;
+    bool        strengthen       (CRef cr, Lit p);
+    bool        backwardSubsumption();
+    bool        merge            (const Clause& ps, const Clause& qs, Var v, vec<Lit>& out) const;
+    bool        eliminateVar     (Var v);
+    void        extendModel      ();
+
     // Activity:
     //
     void     varBumpActivity(Lit p) {
@@ -115,10 +166,13 @@ protected:
     // Operations on clauses:
     //
     void     newClause(const vec<Lit>& ps, bool learnt = false, ClauseId id = ClauseId_NULL, bool A = true);
-    void     claBumpActivity (Clause* c) { if ( (c->activity() += cla_inc) > 1e20 ) claRescaleActivity(); }
-    void     remove          (Clause* c, bool just_dealloc = false);
-    bool     locked          (const Clause* c) const { return reason[var((*c)[0])] == c; }
-    bool     simplify        (Clause* c) const;
+    void     claBumpActivity (Clause& c) { if ( (c.activity() += cla_inc) > 1e20 ) claRescaleActivity(); }
+    void     attach          (CRef cr);
+    void     remove          (CRef cr);
+    bool     locked          (CRef cr) const {
+        const Clause& c = ca[cr];   // (a binary reason may still have its implied literal in 'c[1]')
+        return reason[var(c[0])] == cr || (c.size() == 2 && reason[var(c[1])] == cr); }
+    bool     simplify        (const Clause& c) const;
 
     int      decisionLevel() const { return trail_lim.size(); }
 
@@ -132,27 +186,38 @@ public:
              , qhead            (0)
              , simpDB_assigns   (0)
              , simpDB_props     (0)
+             , phase_saving     (false)
+             , lbd_tiers        (false)
+             , next_reduce      (2000)
+             , budget_end       (-1)
+             , reduce_rounds    (0)
+             , lbd_stamp        (0)
+             , lbd_recent_pos   (0)
+             , lbd_recent_sum   (0)
+             , lbd_total_sum    (0)
+             , lbd_total_cnt    (0)
              , default_params   (SearchParams(0.95, 0.999, 0.02))
              , expensive_ccmin  (2)
+             , garbage_frac     (0.20)
+             , elim_clause_lim  (20)
+             , luby_unit        (100)
+             , lbd_window       (50)
+             , lbd_K            (0.8)
+             , lbd_core         (2)
+             , lbd_tier2        (6)
+             , conflict_budget  (-1)
+             , interrupt        (NULL)
              , proof            (NULL)
              , verbosity        (0)
              , progress_estimate(0)
              , conflict_id      (ClauseId_NULL)
              {
-                vec<Lit> dummy(2,lit_Undef);
-                propagate_tmpbin = Clause_new(false, dummy);
-                analyze_tmpbin   = Clause_new(false, dummy);
                 addUnit_tmp   .growTo(1);
                 addBinary_tmp .growTo(2);
                 addTernary_tmp.growTo(3);
              }
 
-   ~Solver() {
-       for (int i = 0; i < learnts.size(); i++) remove(learnts[i], true);
-       for (int i = 0; i < clauses.size(); i++) if (clauses[i] != NULL) remove(clauses[i], true);
-       remove(propagate_tmpbin, true);
-       remove(analyze_tmpbin, true);
-    }
+   ~Solver() { }   // (clauses are released with 'ca')
 
     // Helpers: (semi-internal)
     //
@@ -173,6 +238,15 @@ public:
     //
     SearchParams    default_params;     // Restart frequency etc.
     int             expensive_ccmin;    // Controls conflict clause minimization. TRUE by default.
+    double          garbage_frac;       // Compact the clause region when this fraction of it is wasted.
+    int             elim_clause_lim;    // Variables whose elimination needs a resolvent longer than this are kept.
+    int             luby_unit;          // Conflicts per unit of the Luby restart sequence.
+    int             lbd_window;         // Number of recent learnts averaged by glucose restarts.
+    double          lbd_K;              // Glucose restart when the recent LBD average times 'lbd_K' exceeds the overall one.
+    int             lbd_core;           // Learnts with LBD up to this are never removed...
+    int             lbd_tier2;          // ...and up to this are kept as long as they take part in conflicts.
+    int64           conflict_budget;    // Conflicts one call of 'solveLimited()' may spend before it gives up (-1 = no limit).
+    volatile bool*  interrupt;          // 'solveLimited()' also gives up once this is TRUE (polled between conflicts). Initialized to NULL.
     Proof*          proof;              // Set this directly after constructing 'Solver' to enable proof logging. Initialized to NULL.
     int             verbosity;          // Verbosity level. 0=silent, 1=some progress report, 2=everything
 
@@ -186,13 +260,33 @@ public:
     void    addClause (const vec<Lit>& ps , bool A = true)  { newClause(ps , false , ClauseId_NULL , A); }  
 	 // (used to be a difference between internal and external method...)
 
+    // Search hints:
+    //
+    void    setPolarity(Var x, bool sgn) { polarity[x] = sgn; }         // Decide 'x' with this sign first (TRUE = negative, the default).
+    void    bumpVar    (Var x, double amount = 1) {                     // Raise the activity of 'x' as 'amount' conflicts would.
+        if ( (activity[x] += var_inc * amount) > 1e100 ) varRescaleActivity();
+        order.update(x); }
+
+    // Preprocessing (top level only, no proof logging; the variables used afterwards must be frozen first):
+    //
+    void    setFrozen   (Var x, bool b) { frozen[x] = b; }
+    bool    isEliminated(Var x) const   { return eliminated[x]; }
+    bool    preprocess  ();
+
     // Solving:
     //
     bool    okay() { return ok; }       // FALSE means solver is in an conflicting state (must never be used again!)
     void    simplifyDB();
-    bool    solve(const vec<Lit>& assumps);
+    lbool   solveLimited(const vec<Lit>& assumps);     // l_Undef if 'conflict_budget' ran out.
+    bool    solve(const vec<Lit>& assumps) { return solveLimited(assumps) == l_True; }
     bool    solve() { vec<Lit> tmp; return solve(tmp); }
 
+    // Portfolio solving (see 'Portfolio.cpp'):
+    //
+    void    setSeed    (double seed) { order.setSeed(seed); }
+    void    copyProblem(Solver& to);
+    lbool   solveRace  (const vec<Lit>& assumps, int n_racers, int64 first_budget);
+
     double      progress_estimate;  // Set by 'search()'.
     vec<lbool>  model;              // If problem is satisfiable, this vector contains the model (if any).
     vec<Lit>    conflict;           // If problem is unsatisfiable under assumptions, this vector represent the conflict clause expressed in the assumptions.
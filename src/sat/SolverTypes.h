@@ -79,62 +79,120 @@ inline int toDimacs(Lit p) { return sign(p) ? -var(p) - 1 : var(p) + 1; }
 typedef int ClauseId;     // (might have to use uint64 one day...)
 const   int ClauseId_NULL = INT_MIN;
 
+typedef uint CRef;        // Clause reference: offset (in words) of a clause inside its 'ClauseAllocator'.
+const   CRef CRef_Undef = UINT_MAX;
+
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 class Clause {
-    uint    size_learnt;
+    uint    header;     // size << 10 | removed << 9 | used << 8 | lbd << 3 | reloced << 2 | has_id << 1 | learnt
     Lit     data[1];
 public:
     // NOTE: This constructor cannot be used directly (doesn't allocate enough memory).
     Clause(bool learnt, const vec<Lit>& ps, ClauseId id_ = ClauseId_NULL) {
-        size_learnt = (ps.size() << 1) | (int)learnt;
+        header = (ps.size() << 10) | ((int)(id_ != ClauseId_NULL) << 1) | (int)learnt;
         for (int i = 0; i < ps.size(); i++) data[i] = ps[i];
         if (learnt) activity() = 0;
         if (id_ != ClauseId_NULL) id() = id_; }
 
-    // -- use this function instead:
-    friend Clause* Clause_new(bool, const vec<Lit>&, ClauseId);
-
-    int       size        ()      const { return size_learnt >> 1; }
-    bool      learnt      ()      const { return size_learnt & 1; }
+    // -- allocate through 'ClauseAllocator::alloc()' instead:
+    friend class ClauseAllocator;
+
+    int       size        ()      const { return header >> 10; }
+    bool      learnt      ()      const { return header & 1; }
+    bool      hasId       ()      const { return header & 2; }
+    bool      reloced     ()      const { return header & 4; }
+    int       lbd         ()      const { return (header >> 3) & 31; }
+    void      setLbd      (int l)       { header = (header & ~(31u << 3)) | ((uint)(l < 31 ? l : 31) << 3); }
+    bool      used        ()      const { return header & 256; }
+    void      setUsed     (bool b)      { header = b ? header | 256 : header & ~256u; }
+    bool      removed     ()      const { return header & 512; }
+    int       words       ()      const { return 1 + size() + (int)learnt() + (int)hasId(); }
     Lit       operator [] (int i) const { return data[i]; }
     Lit&      operator [] (int i)       { return data[i]; }
     float&    activity    ()      const {
         void *p = const_cast<Lit*>(&data[size()]); return *((float *)p);
     } //              return *((float*)&data[size()]); }
     ClauseId& id          ()      const { return *((ClauseId*)&data[size() + (int)learnt()]); }
+    CRef&     relocation  ()      const { return *((CRef*)&data[0]); }
+    void      relocate    (CRef c)      { header |= 4; relocation() = c; }
 };
 
-inline Clause* Clause_new(bool learnt, const vec<Lit>& ps, ClauseId id = ClauseId_NULL) {
-    assert(sizeof(Lit)      == sizeof(uint));
-    assert(sizeof(float)    == sizeof(uint));
-    assert(sizeof(ClauseId) == sizeof(uint));
-    void*   mem = xmalloc<char>(sizeof(Clause) + sizeof(uint)*(ps.size() + (int)learnt + (int)(id != ClauseId_NULL)));
-    return new (mem) Clause(learnt, ps, id); }
-
 
 //=================================================================================================
-// GClause -- Generalize clause:
+// ClauseAllocator -- all clauses of a solver live in one growable 'uint' region:
+
 
+// Clauses are addressed by 32-bit offsets ('CRef') rather than pointers. A reference stays valid
+// when the region grows; a 'Clause&' does not, so never hold one across an 'alloc()'. Freed
+// clauses are only counted as wasted; 'reloc()' into a fresh allocator compacts the region.
+//
+class ClauseAllocator {
+    uint*   memory;
+    uint    sz;
+    uint    cap;
+    uint    wasted_;
+
+    void    capacity(uint min_cap) {
+        if (cap >= min_cap) return;
+        while (cap < min_cap) cap = cap + (cap >> 1) + 2;
+        memory = xrealloc(memory, cap); }
 
-// Either a pointer to a clause or a literal.
-class GClause {
-    void*   data;
-    GClause(void* d) : data(d) {}
 public:
-    friend GClause GClause_new(Lit p);
-    friend GClause GClause_new(Clause* c);
-
-    bool        isLit    () const { return ((uintp)data & 1) == 1; }
-    Lit         lit      () const { return toLit(((intp)data) >> 1); }
-    Clause*     clause   () const { return (Clause*)data; }
-    bool        operator == (GClause c) const { return data == c.data; }
-    bool        operator != (GClause c) const { return data != c.data; }
+    ClauseAllocator(uint start_cap = 1024) : memory(NULL), sz(0), cap(0), wasted_(0) { capacity(start_cap); }
+   ~ClauseAllocator() { xfree(memory); }
+
+    uint     size    () const { return sz; }
+    uint     wasted  () const { return wasted_; }
+
+    CRef     alloc   (bool learnt, const vec<Lit>& ps, ClauseId id = ClauseId_NULL) {
+        assert(sizeof(Lit)      == sizeof(uint));
+        assert(sizeof(float)    == sizeof(uint));
+        assert(sizeof(ClauseId) == sizeof(uint));
+        uint    words = 1 + ps.size() + (int)learnt + (int)(id != ClauseId_NULL);
+        capacity(sz + words);
+        CRef    cr = sz; sz += words;
+        new (&memory[cr]) Clause(learnt, ps, id);
+        return cr; }
+    void     free    (CRef cr) { Clause& c = (*this)[cr]; c.header |= 512; wasted_ += c.words(); }
+
+    Clause&       operator [] (CRef cr)       { return *(Clause*)&memory[cr]; }
+    const Clause& operator [] (CRef cr) const { return *(const Clause*)&memory[cr]; }
+
+    // Move 'cr' into 'to' (once; later calls just follow the forwarding reference):
+    void     reloc   (CRef& cr, ClauseAllocator& to) {
+        Clause& c = (*this)[cr];
+        if (c.reloced()){ cr = c.relocation(); return; }
+        uint    words = c.words();
+        to.capacity(to.sz + words);
+        CRef    ncr = to.sz; to.sz += words;
+        memcpy(&to.memory[ncr], &memory[cr], words * sizeof(uint));
+        c.relocate(ncr);
+        cr = ncr; }
+
+    // Take over the region of 'from' (which is left empty):
+    void     moveFrom(ClauseAllocator& from) {
+        xfree(memory);
+        memory = from.memory; sz = from.sz; cap = from.cap; wasted_ = from.wasted_;
+        from.memory = NULL; from.sz = from.cap = from.wasted_ = 0; }
 };
-inline GClause GClause_new(Lit p)     { return GClause((void*)(((intp)index(p) << 1) + 1)); }
-inline GClause GClause_new(Clause* c) { assert(((uintp)c & 1) == 0); return GClause((void*)c); }
 
-#define GClause_NULL GClause_new((Clause*)NULL)
+
+//=================================================================================================
+// Watcher -- an entry of a watch list:
+
+
+// 'blocker' is some other literal of the clause; if it is already true the clause is satisfied and
+// need not be visited. In the binary watch lists 'blocker' is the other literal itself, so a binary
+// clause is propagated without dereferencing 'cref' at all.
+struct Watcher {
+    CRef    cref;
+    Lit     blocker;
+    Watcher() : cref(CRef_Undef) {}
+    Watcher(CRef cr, Lit p) : cref(cr), blocker(p) {}
+    bool    operator == (const Watcher& w) const { return cref == w.cref; }
+    bool    operator != (const Watcher& w) const { return cref != w.cref; }
+};
 
 
 //=================================================================================================
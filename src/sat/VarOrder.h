@@ -48,6 +48,7 @@ public:
     inline void update(Var x);                  // Called when variable increased in activity.
     inline void undo(Var x);                    // Called when variable is unassigned and may be selected again.
     inline Var  select(double random_freq =.0); // Selects a new, unassigned variable (or 'var_Undef' if none exists).
+    void        setSeed(double seed) { random_seed = seed; }
 };
 
 
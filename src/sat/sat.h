@@ -11,15 +11,43 @@
 
 #include <cassert>
 #include <iostream>
+#include <vector>
+#include <algorithm>
 #include "Solver.h"
 
 using namespace std;
 
+// One candidate equivalence of a batch: va == vb (vb inverted if fb).
+// Pairs are solved in ascending "order" (e.g. topological level), so the
+// clauses learnt on the smaller cones are at hand for the larger ones
+struct SatPair
+{
+   SatPair(Var a, Var b, bool f, size_t o): va(a), vb(b), fb(f), order(o) {}
+   Var      va, vb;
+   bool     fb;
+   size_t   order;
+};
+
+enum SatPairStatus
+{
+   SAT_PAIR_UNTRIED,    // left out after the batch reached its SAT limit
+   SAT_PAIR_DIFF,       // satisfiable; "model" holds a distinguishing input
+   SAT_PAIR_EQUIV,      // unsatisfiable
+   SAT_PAIR_ABORT       // the conflict budget ran out
+};
+
+struct SatPairResult
+{
+   SatPairResult(): status(SAT_PAIR_UNTRIED) {}
+   SatPairStatus  status;
+   vector<int>    model;     // getValue() of the batch's "modelVars"
+};
+
 /********** MiniSAT_Solver **********/
 class SatSolver
 {
    public : 
-      SatSolver():_solver(0) { }
+      SatSolver():_solver(0), _proof(0), _raceNum(1), _raceBudget(0) { }
       ~SatSolver() { }
 
       // Solver initialization and reset
@@ -30,9 +58,41 @@ class SatSolver
       void reset() {
          if (_solver) delete _solver;
          _solver = new Solver();
+         _solver->proof = _proof;
+         if (_proof) _proof->newSolver();
          _assump.clear(); _curVar = 0;
       }
 
+      // Proof logging: the resolution proofs of all models initialized from
+      // now on go to "fileName" (in the binary format of 'Proof'), until it
+      // is set to ""; return false if the file cannot be created
+      bool setProof(const string& fileName) {
+         if (_proof) { _proof->end(); delete _proof; _proof = 0; }
+         if (!fileName.empty()) {
+            _proof = new Proof(fileName.c_str());
+            if (_proof->null()) { delete _proof; _proof = 0; return false; }
+         }
+         if (_solver) _solver->proof = _proof;
+         return true;
+      }
+      bool hasProof() const { return _proof != 0; }
+      // Log that the last query, refuted under "act", proved va == vb
+      // (vb inverted if fb), and that objects "x" and "y" were merged on it
+      void logQuery(Var act, Var va, Var vb, bool fb) {
+         if (!_proof) return;
+         _proof->vars(_solver->nVars());
+         _proof->query(_solver->conflict_id, Lit(act), Lit(va), fb? ~Lit(vb): Lit(vb));
+      }
+      void logMerge(unsigned x, unsigned y, Var va, Var vb, bool fb) {
+         if (!_proof) return;
+         _proof->vars(_solver->nVars());
+         _proof->merge(x, y, Lit(va), fb? ~Lit(vb): Lit(vb));
+      }
+      // Replay a proof file, checking its resolution steps and merges
+      static bool checkProof(const string& fileName, ProofChecker& checker) {
+         return Proof::replay(fileName.c_str(), checker);
+      }
+
       // Constructing proof model
       // Return the Var ID of the new Var
       inline Var newVar() { _solver->newVar(); return _curVar++; }
@@ -64,13 +124,87 @@ class SatSolver
          lits.push(~la); lits.push(~lb); lits.push(~lf);
          _solver->addClause(lits); lits.clear();
       }
+      // Equivalence miter guarded by a fresh activation variable "act":
+      // act -> (va != vb), vb inverted if fb. Assume "act" to query the miter
+      // and disable it afterwards; simplifyDB() then purges its clauses
+      // (and the learnt ones that depend on it) as satisfied
+      Var addXorMiter(Var va, Var vb, bool fb) {
+         Var act = newVar();
+         vec<Lit> lits;
+         Lit la = Lit(va);
+         Lit lb = fb? ~Lit(vb): Lit(vb);
+         lits.push(~Lit(act)); lits.push( la); lits.push( lb);
+         _solver->addClause(lits); lits.clear();
+         lits.push(~Lit(act)); lits.push(~la); lits.push(~lb);
+         _solver->addClause(lits); lits.clear();
+         return act;
+      }
+      void disableMiter(Var act) { _solver->addUnit(~Lit(act)); }
+
+      // Search hints: preferred value and decision priority of a variable
+      void setPhase(Var v, bool val) { _solver->setPolarity(v, !val); }
+      void boostVar(Var v, double amount = 1) { _solver->bumpVar(v, amount); }
+
+      // Simplification: variables read or assumed later must be frozen first
+      void freezeVar(Var v) { _solver->setFrozen(v, true); }
+      bool preprocess() { return _solver->preprocess(); }
 
       // For incremental proof, use "assumeSolve()"
       void assumeRelease() { _assump.clear(); }
       void assumeProperty(Var prop, bool val) {
          _assump.push(val? Lit(prop): ~Lit(prop));
       }
-      bool assumpSolve() { return _solver->solve(_assump); }
+      bool assumpSolve() {
+         return _solver->solveRace(_assump, _raceNum, _raceBudget) == l_True; }
+
+      // Race a query still open after "budget" conflicts on up to "racers"
+      // threads (at most one per processor); 1 solves on this thread only
+      void setRace(int racers, int64 budget) {
+         _raceNum = racers; _raceBudget = budget; }
+
+      // Solve every pair of "pairs" over the current CNF; "results" is
+      // indexed like "pairs". Each query may spend "budget" conflicts (-1
+      // for no limit), and the batch stops after "satLimit" SAT pairs.
+      // Without proof logging a proven pair is kept as two binary clauses
+      // for the later queries. Return the number of SAT pairs
+      size_t solveBatch(const vector<SatPair>& pairs, const vector<Var>& modelVars,
+                        vector<SatPairResult>& results, int64 budget = -1,
+                        size_t satLimit = (size_t)-1) {
+         vector<size_t> idx(pairs.size());
+         for (size_t i = 0; i < idx.size(); ++i) idx[i] = i;
+         sort(idx.begin(), idx.end(), PairOrder(pairs));
+         results.assign(pairs.size(), SatPairResult());
+         size_t satNum = 0;
+         int64 oldBudget = _solver->conflict_budget;
+         _solver->conflict_budget = budget;
+         for (size_t i = 0; i < idx.size() && satNum < satLimit; ++i) {
+            const SatPair& p = pairs[idx[i]];
+            SatPairResult& r = results[idx[i]];
+            Var act = addXorMiter(p.va, p.vb, p.fb);
+            boostVar(p.va, 2); boostVar(p.vb, 2);
+            _assump.clear(); _assump.push(Lit(act));
+            lbool st = _solver->solveRace(_assump, _raceNum, _raceBudget);
+            if (st == l_False) logQuery(act, p.va, p.vb, p.fb);
+            disableMiter(act);
+            if (st == l_True) {
+               r.status = SAT_PAIR_DIFF; ++satNum;
+               r.model.resize(modelVars.size());
+               for (size_t j = 0; j < modelVars.size(); ++j)
+                  r.model[j] = getValue(modelVars[j]);
+            }
+            else if (st == l_False) {
+               r.status = SAT_PAIR_EQUIV;
+               if (!_proof) {
+                  Lit la = Lit(p.va), lb = p.fb? ~Lit(p.vb): Lit(p.vb);
+                  _solver->addBinary(~la, lb); _solver->addBinary(la, ~lb);
+               }
+            }
+            else r.status = SAT_PAIR_ABORT;
+         }
+         _solver->conflict_budget = oldBudget;
+         _assump.clear();
+         return satNum;
+      }
 
       // For one time proof, use "solve"
       void assertProperty(Var prop, bool val) {
@@ -86,9 +220,21 @@ class SatSolver
       void printStats() const { const_cast<Solver*>(_solver)->printStats(); }
 
    private : 
+      struct PairOrder {
+         PairOrder(const vector<SatPair>& p): _p(p) {}
+         bool operator () (size_t i, size_t j) const {
+            if (_p[i].order != _p[j].order) return _p[i].order < _p[j].order;
+            return i < j;
+         }
+         const vector<SatPair>& _p;
+      };
+
       Solver           *_solver;    // Pointer to a Minisat solver
       Var               _curVar;    // Variable currently
+      Proof            *_proof;     // Proof log shared by the successive solvers
       vec<Lit>          _assump;    // Assumption List for assumption solve
+      int               _raceNum;   // Racing solvers for hard queries (1: none)
+      int64             _raceBudget;// Conflicts before a query is raced
 };
 
 #endif  // SAT_H